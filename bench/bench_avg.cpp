@@ -0,0 +1,21 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright Georgy Guminov 2023-2024.
+// Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt
+//  or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include <dst/partial/dynamic_avg_segment_tree.hpp>
+#include <functional>
+
+#include "tree_benchmarks.hpp"
+
+namespace {
+
+using AvgTree =
+    dst::DynamicAvgSegmentTree<bench::Key, int, double, std::plus<int>>;
+
+}  // namespace
+
+DST_BENCH_SET_GET(AvgTree);
+DST_BENCH_ALL_DISTRIBUTIONS(benchRangeGet, AvgTree);
+DST_BENCH_ALL_DISTRIBUTIONS(benchUpdate, AvgTree);
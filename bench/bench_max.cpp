@@ -0,0 +1,20 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright Georgy Guminov 2023-2024.
+// Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt
+//  or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include <dst/partial/dynamic_max_segment_tree.hpp>
+#include <functional>
+
+#include "tree_benchmarks.hpp"
+
+namespace {
+
+using MaxTree = dst::DynamicMaxSegmentTree<bench::Key, int, std::plus<int>>;
+
+}  // namespace
+
+DST_BENCH_SET_GET(MaxTree);
+DST_BENCH_ALL_DISTRIBUTIONS(benchRangeGet, MaxTree);
+DST_BENCH_ALL_DISTRIBUTIONS(benchUpdate, MaxTree);
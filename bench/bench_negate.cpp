@@ -0,0 +1,23 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright Georgy Guminov 2023-2024.
+// Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt
+//  or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include <dst/comb.hpp>
+#include <dst/partial/dynamic_negate_segment_tree.hpp>
+#include <functional>
+
+#include "tree_benchmarks.hpp"
+
+namespace {
+
+using NegateTree =
+    dst::DynamicNegateSegmentTree<bench::Key, int, int, dst::comb::Min<int>,
+                                  std::identity>;
+
+}  // namespace
+
+DST_BENCH_SET_GET(NegateTree);
+DST_BENCH_ALL_DISTRIBUTIONS(benchRangeGet, NegateTree);
+DST_BENCH_ALL_DISTRIBUTIONS(benchUpdate, NegateTree);
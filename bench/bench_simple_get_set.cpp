@@ -0,0 +1,28 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright Georgy Guminov 2023-2024.
+// Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt
+//  or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include <dst/partial/dynamic_simple_get_set_segment_tree.hpp>
+#include <dst/static_range_dynamic_segment_tree.hpp>
+
+#include "tree_benchmarks.hpp"
+
+namespace {
+
+using SimpleGetSetTree = dst::DynamicSimpleGetSetSegmentTree<bench::Key, int>;
+
+constexpr auto kStaticWidth = bench::Key{1} << 20;
+
+using StaticGetSetTree =
+    dst::StaticRangeDynamicSegmentTree<bench::Key, 0, kStaticWidth, int>;
+
+}  // namespace
+
+DST_BENCH_SET_GET(SimpleGetSetTree);
+
+BENCHMARK_TEMPLATE(benchGet, StaticGetSetTree, bench::Uniform)
+    ->Arg(kStaticWidth);
+BENCHMARK_TEMPLATE(benchGet, StaticGetSetTree, bench::Zipfian)
+    ->Arg(kStaticWidth);
@@ -0,0 +1,25 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright Georgy Guminov 2023-2024.
+// Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt
+//  or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include <cstdint>
+#include <dst/partial/dynamic_sum_segment_tree.hpp>
+#include <functional>
+
+#include "tree_benchmarks.hpp"
+
+namespace {
+
+using SumTree = dst::DynamicSumSegmentTree<bench::Key, int, std::int64_t,
+                                            std::plus<int>>;
+
+}  // namespace
+
+DST_BENCH_SET_GET(SumTree);
+DST_BENCH_ALL_DISTRIBUTIONS(benchSetBatch, SumTree);
+DST_BENCH_ALL_DISTRIBUTIONS(benchGetMany, SumTree);
+DST_BENCH_ALL_DISTRIBUTIONS(benchRangeGet, SumTree);
+DST_BENCH_ALL_DISTRIBUTIONS(benchRangeGetBatch, SumTree);
+DST_BENCH_ALL_DISTRIBUTIONS(benchUpdate, SumTree);
@@ -0,0 +1,125 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright Georgy Guminov 2023-2024.
+// Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt
+//  or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef KEY_DISTRIBUTIONS_HPP
+#define KEY_DISTRIBUTIONS_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace bench {
+
+using Key = std::int64_t;
+using KeyRange = std::pair<Key, Key>;
+
+constexpr auto kSeed = std::uint32_t{42};
+constexpr auto kMaxRangeLength = Key{64};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Keys are uniformly distributed over the whole tree. Ranges have
+/// uniformly distributed borders.
+class Uniform {
+ public:
+  explicit Uniform(Key width) : width_(width) {
+  }
+
+  Key key(std::mt19937& generator) const {
+    return std::uniform_int_distribution<Key>(0, width_ - 1)(generator);
+  }
+
+  KeyRange range(std::mt19937& generator) const {
+    auto dist = std::uniform_int_distribution<Key>(0, width_);
+    auto first = dist(generator);
+    auto second = dist(generator);
+    if (first > second) {
+      std::swap(first, second);
+    }
+    first = std::min(first, width_ - 1);
+    return {first, std::max(second, first + 1)};
+  }
+
+ private:
+  Key width_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Key k is chosen with probability proportional to 1 / (k + 1)
+/// (continuous zipfian law with exponent 1). Ranges are short and start at
+/// such keys.
+class Zipfian {
+ public:
+  explicit Zipfian(Key width)
+      : width_(width), logWidth_(std::log(static_cast<double>(width) + 1)) {
+  }
+
+  Key key(std::mt19937& generator) const {
+    const auto power = std::uniform_real_distribution<double>(0, 1)(generator);
+    const auto key = static_cast<Key>(std::exp(power * logWidth_) - 1);
+    return std::clamp(key, Key{0}, width_ - 1);
+  }
+
+  KeyRange range(std::mt19937& generator) const {
+    const auto begin = key(generator);
+    const auto length =
+        std::uniform_int_distribution<Key>(1, kMaxRangeLength)(generator);
+    return {begin, std::min(begin + length, width_)};
+  }
+
+ private:
+  Key width_;
+  double logWidth_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Keys and short ranges go one after another, wrapping around the
+/// tree end.
+class Sequential {
+ public:
+  explicit Sequential(Key width) : width_(width) {
+  }
+
+  Key key(std::mt19937& /*generator*/) {
+    return std::exchange(next_, (next_ + 1) % width_);
+  }
+
+  KeyRange range(std::mt19937& /*generator*/) {
+    const auto begin = std::exchange(next_, (next_ + kMaxRangeLength) % width_);
+    return {begin, std::min(begin + kMaxRangeLength, width_)};
+  }
+
+ private:
+  Key width_;
+  Key next_{0};
+};
+
+////////////////////////////////////////////////////////////////////////////////
+template <class Dist>
+std::vector<Key> makeKeys(Key width, std::size_t count) {
+  auto generator = std::mt19937(kSeed);
+  auto dist = Dist(width);
+  auto ret = std::vector<Key>(count);
+  std::ranges::generate(ret, [&] { return dist.key(generator); });
+  return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <class Dist>
+std::vector<KeyRange> makeRanges(Key width, std::size_t count) {
+  auto generator = std::mt19937(kSeed);
+  auto dist = Dist(width);
+  auto ret = std::vector<KeyRange>(count);
+  std::ranges::generate(ret, [&] { return dist.range(generator); });
+  return ret;
+}
+
+}  // namespace bench
+
+#endif  // KEY_DISTRIBUTIONS_HPP
@@ -0,0 +1,255 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright Georgy Guminov 2023-2024.
+// Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt
+//  or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef TREE_BENCHMARKS_HPP
+#define TREE_BENCHMARKS_HPP
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "key_distributions.hpp"
+
+namespace bench {
+
+constexpr auto kOpsCount = std::size_t{1 << 12};
+constexpr auto kPrefillSetsCount = std::size_t{1 << 10};
+constexpr auto kBatchSize = std::size_t{1 << 8};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Tree widths every benchmark is run with.
+inline void treeWidths(benchmark::internal::Benchmark* bench) {
+  bench->Arg(Key{1} << 10)->Arg(Key{1} << 16)->Arg(Key{1} << 20);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Make a tree of the given width, fragmented with uniformly
+/// distributed set operations.
+template <class Tree>
+Tree makePrefilledTree(Key width) {
+  auto tree = [width]() {
+    if constexpr (requires { Tree::kEnd; }) {
+      // A working area of a static range tree is fixed.
+      assert(Tree::kBegin == 0 && Tree::kEnd == width);
+      return Tree(0);
+    } else {
+      return Tree(0, width, 0);
+    }
+  }();
+  auto value = 0;
+  for (const auto& [begin, end] :
+       makeRanges<Uniform>(width, kPrefillSetsCount)) {
+    tree.set(begin, end, ++value);
+  }
+  return tree;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <class Tree, class Dist>
+void benchSet(benchmark::State& state) {
+  const auto width = static_cast<Key>(state.range(0));
+  const auto ranges = makeRanges<Dist>(width, kOpsCount);
+  auto tree = makePrefilledTree<Tree>(width);
+  auto idx = std::size_t{0};
+  for (auto _ : state) {
+    const auto& [begin, end] = ranges[idx++ % kOpsCount];
+    tree.set(begin, end, static_cast<int>(idx % 128));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Set operations applied with setBatch, kBatchSize at a time. Items
+/// are single set operations, so results are comparable with benchSet.
+template <class Tree, class Dist>
+void benchSetBatch(benchmark::State& state) {
+  const auto width = static_cast<Key>(state.range(0));
+  const auto ranges = makeRanges<Dist>(width, kOpsCount);
+  auto batches = std::vector<std::vector<std::tuple<Key, Key, int>>>();
+  for (std::size_t i = 0; i < kOpsCount; ++i) {
+    if (i % kBatchSize == 0) {
+      batches.emplace_back();
+    }
+    const auto& [begin, end] = ranges[i];
+    batches.back().emplace_back(begin, end, static_cast<int>(i % 128));
+  }
+  auto tree = makePrefilledTree<Tree>(width);
+  auto idx = std::size_t{0};
+  for (auto _ : state) {
+    tree.setBatch(batches[idx++ % batches.size()]);
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<std::int64_t>(kBatchSize));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <class Tree, class Dist>
+void benchGet(benchmark::State& state) {
+  const auto width = static_cast<Key>(state.range(0));
+  const auto keys = makeKeys<Dist>(width, kOpsCount);
+  auto tree = makePrefilledTree<Tree>(width);
+  auto idx = std::size_t{0};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(tree.get(keys[idx++ % kOpsCount]));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Windows of kBatchSize consecutive keys read with getMany. Windows
+/// start at keys of the given distribution. Items are single keys.
+template <class Tree, class Dist>
+void benchGetMany(benchmark::State& state) {
+  const auto width = static_cast<Key>(state.range(0));
+  auto windows = std::vector<std::vector<Key>>();
+  for (const Key first : makeKeys<Dist>(width, kOpsCount / kBatchSize)) {
+    auto& window = windows.emplace_back(kBatchSize);
+    std::iota(window.begin(), window.end(),
+              std::min(first, width - static_cast<Key>(kBatchSize)));
+  }
+  auto tree = makePrefilledTree<Tree>(width);
+  auto values = std::vector<std::remove_cvref_t<decltype(tree.get(0))>>(
+      kBatchSize);
+  auto idx = std::size_t{0};
+  for (auto _ : state) {
+    tree.getMany(windows[idx++ % windows.size()], values.begin());
+    benchmark::DoNotOptimize(values.data());
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<std::int64_t>(kBatchSize));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <class Tree, class Dist>
+void benchRangeGet(benchmark::State& state) {
+  const auto width = static_cast<Key>(state.range(0));
+  const auto ranges = makeRanges<Dist>(width, kOpsCount);
+  auto tree = makePrefilledTree<Tree>(width);
+  auto idx = std::size_t{0};
+  for (auto _ : state) {
+    const auto& [begin, end] = ranges[idx++ % kOpsCount];
+    benchmark::DoNotOptimize(tree.rangeGet(begin, end));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Range queries answered with rangeGetBatch, kBatchSize at a time.
+/// Items are single queries, so results are comparable with benchRangeGet.
+template <class Tree, class Dist>
+void benchRangeGetBatch(benchmark::State& state) {
+  const auto width = static_cast<Key>(state.range(0));
+  const auto ranges = makeRanges<Dist>(width, kOpsCount);
+  auto tree = makePrefilledTree<Tree>(width);
+  auto results = std::vector<decltype(tree.rangeGet(0, 1))>(kBatchSize);
+  auto idx = std::size_t{0};
+  for (auto _ : state) {
+    const auto batchBegin = (idx++ * kBatchSize) % kOpsCount;
+    tree.rangeGetBatch(std::span(ranges).subspan(batchBegin, kBatchSize),
+                       results);
+    benchmark::DoNotOptimize(results.data());
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<std::int64_t>(kBatchSize));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <class Tree, class Dist>
+void benchUpdate(benchmark::State& state) {
+  const auto width = static_cast<Key>(state.range(0));
+  const auto ranges = makeRanges<Dist>(width, kOpsCount);
+  auto tree = makePrefilledTree<Tree>(width);
+  auto idx = std::size_t{0};
+  for (auto _ : state) {
+    const auto& [begin, end] = ranges[idx++ % kOpsCount];
+    if constexpr (requires { tree.update(begin, end); }) {
+      tree.update(begin, end);
+    } else {
+      tree.update(begin, end, 1);
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Copy construction of a tree, fragmented with operations of the
+/// given distribution. Destruction of a copy is not measured.
+template <class Tree, class Dist>
+void benchCopy(benchmark::State& state) {
+  const auto width = static_cast<Key>(state.range(0));
+  auto tree = makePrefilledTree<Tree>(width);
+  for (const auto& [begin, end] : makeRanges<Dist>(width, kOpsCount)) {
+    tree.set(begin, end, 1);
+  }
+  auto copy = std::optional<Tree>();
+  for (auto _ : state) {
+    copy.emplace(tree);
+    state.PauseTiming();
+    copy.reset();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Destruction of a tree, fragmented with operations of the given
+/// distribution.
+template <class Tree, class Dist>
+void benchDestroy(benchmark::State& state) {
+  const auto width = static_cast<Key>(state.range(0));
+  auto tree = makePrefilledTree<Tree>(width);
+  for (const auto& [begin, end] : makeRanges<Dist>(width, kOpsCount)) {
+    tree.set(begin, end, 1);
+  }
+  auto copy = std::optional<Tree>();
+  for (auto _ : state) {
+    state.PauseTiming();
+    copy.emplace(tree);
+    state.ResumeTiming();
+    copy.reset();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+}  // namespace bench
+
+// Benchmark registration macros need unqualified function names.
+using bench::benchCopy;
+using bench::benchDestroy;
+using bench::benchGet;
+using bench::benchGetMany;
+using bench::benchRangeGet;
+using bench::benchRangeGetBatch;
+using bench::benchSet;
+using bench::benchSetBatch;
+using bench::benchUpdate;
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Register a benchmark for a tree with all key distributions and tree
+/// widths.
+#define DST_BENCH_ALL_DISTRIBUTIONS(func, Tree)                               \
+  BENCHMARK_TEMPLATE(func, Tree, bench::Uniform)->Apply(bench::treeWidths);   \
+  BENCHMARK_TEMPLATE(func, Tree, bench::Zipfian)->Apply(bench::treeWidths);   \
+  BENCHMARK_TEMPLATE(func, Tree, bench::Sequential)->Apply(bench::treeWidths)
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Register set, get, copy and destruction benchmarks for a tree.
+#define DST_BENCH_SET_GET(Tree)                  \
+  DST_BENCH_ALL_DISTRIBUTIONS(benchSet, Tree);   \
+  DST_BENCH_ALL_DISTRIBUTIONS(benchGet, Tree);   \
+  DST_BENCH_ALL_DISTRIBUTIONS(benchCopy, Tree);  \
+  DST_BENCH_ALL_DISTRIBUTIONS(benchDestroy, Tree)
+
+#endif  // TREE_BENCHMARKS_HPP
@@ -0,0 +1,61 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright Georgy Guminov 2023-2024.
+// Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt
+// or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef CACHE_UPD_HPP
+#define CACHE_UPD_HPP
+
+#include <dst/key_range.hpp>
+
+namespace dst::cache_upd {
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief The AddToSum<GetValueT> class. Sum of a segment after an addition
+/// to each of its values.
+///
+/// \tparam GetValueT rangeGet operation return type.
+///
+template <class GetValueT>
+struct AddToSum {
+  template <class UpdateArgT, class KeyT>
+  GetValueT operator()(const GetValueT& sum, const UpdateArgT& toAdd,
+                       KeyT begin, KeyT end) const {
+    return sum + static_cast<GetValueT>(toAdd) * impl::keyDistance(begin, end);
+  }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief The AddToExtreme<GetValueT> class. Minimum or maximum of a segment
+/// after an addition to each of its values.
+///
+/// \tparam GetValueT rangeGet operation return type.
+///
+template <class GetValueT>
+struct AddToExtreme {
+  template <class UpdateArgT, class KeyT>
+  GetValueT operator()(const GetValueT& extreme, const UpdateArgT& toAdd,
+                       KeyT /*begin*/, KeyT /*end*/) const {
+    return extreme + toAdd;
+  }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief The NegateSum<GetValueT> class. Sum of a segment after negation of
+/// each of its values.
+///
+/// \tparam GetValueT rangeGet operation return type.
+///
+template <class GetValueT>
+struct NegateSum {
+  template <class KeyT>
+  GetValueT operator()(const GetValueT& sum, KeyT /*begin*/,
+                       KeyT /*end*/) const {
+    return -sum;
+  }
+};
+
+}  // namespace dst::cache_upd
+
+#endif  // CACHE_UPD_HPP
@@ -4,6 +4,9 @@
 // Version 1.0. (See accompanying file LICENSE_1_0.txt
 // or copy at https://www.boost.org/LICENSE_1_0.txt)
 
+#ifndef COMB_HPP
+#define COMB_HPP
+
 #include <algorithm>
 
 namespace dst::comb {
@@ -59,4 +62,6 @@ struct Avg {
   }
 };
 
-}  // namespace dst::comb
\ No newline at end of file
+}  // namespace dst::comb
+
+#endif  // COMB_HPP
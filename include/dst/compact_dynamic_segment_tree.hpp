@@ -0,0 +1,577 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright Georgy Guminov 2023-2024.
+// Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt
+// or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef COMPACT_DYNAMIC_SEGMENT_TREE_HPP
+#define COMPACT_DYNAMIC_SEGMENT_TREE_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <concepts>
+#include <cstdint>
+#include <dst/concepts.hpp>
+#include <dst/disable_operations.hpp>
+#include <dst/impl/dynamic_segment_tree_range_get_variation_base.hpp>
+#include <dst/impl/pending.hpp>
+#include <dst/key_range.hpp>
+#include <dst/mp.hpp>
+#include <dst/upd.hpp>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace dst {
+
+namespace impl {
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief The CompactNode<ValueT, PendingT> class. Node of a compact tree.
+///
+/// Children are stored next to each other in one vector. `children` is an
+/// index of the left child, zero for a leaf (root has index zero and is never
+/// a child). `value` is meaningful only for leaves.
+///
+template <class ValueT, class PendingT>
+struct CompactNode {
+  ValueT value;
+  std::uint32_t children{0};
+  [[no_unique_address]] PendingT pending{};
+
+  [[nodiscard]] bool isLeaf() const {
+    return children == 0;
+  }
+
+  [[nodiscard]] bool hasPendingUpdate() const {
+    return isPending(pending);
+  }
+
+  [[nodiscard]] const auto& getPendingUpdate() const {
+    return *pending;
+  }
+};
+
+}  // namespace impl
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief The CompactDynamicSegmentTree class. Dynamic segment tree, which
+/// keeps all nodes in one contiguous vector and refers to children by 32-bit
+/// indices.
+///
+/// Template parameters have the same meaning as for DynamicSegmentTree.
+/// Compared to it nodes are smaller and located densely, copying is a copy of
+/// one vector. Freed children pairs are reused. The number of nodes is limited
+/// by 2^32.
+///
+/// Like in DynamicSegmentTree, get and rangeGet apply delayed updates on the
+/// fly and never modify a tree, so it can be queried from several threads.
+///
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb = NoRangeGetOp,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit =
+              NoRangeGetOp,
+          class UpdateOp = NoUpdateOp,
+          class UpdateArgT = mp::DefaultUpdateArgT<UpdateOp, ValueT>,
+          class Allocator = std::allocator<ValueT>>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+class CompactDynamicSegmentTree
+    : protected impl::DynamicSegmentTreeRangeGetCombineVariationBase<
+          KeyT, GetValueT, SegGetComb>,
+      protected impl::DynamicSegmentTreeRangeGetInitVariationBase<
+          KeyT, ValueT, GetValueT, SegGetInit> {
+ private:
+  using RangeGetCombineVariationBase_ =
+      impl::DynamicSegmentTreeRangeGetCombineVariationBase<KeyT, GetValueT,
+                                                           SegGetComb>;
+
+  using RangeGetInitVariationBase_ =
+      impl::DynamicSegmentTreeRangeGetInitVariationBase<KeyT, ValueT,
+                                                        GetValueT, SegGetInit>;
+
+  using Pending_ = impl::NodePending<UpdateOp, ValueT, UpdateArgT>::Type;
+  using Node_ = impl::CompactNode<ValueT, Pending_>;
+  using NodeAlloc_ =
+      std::allocator_traits<Allocator>::template rebind_alloc<Node_>;
+  using IndexAlloc_ =
+      std::allocator_traits<Allocator>::template rebind_alloc<std::uint32_t>;
+
+  constexpr static bool kOneArgUpdate_ = conc::OneArgUpdateOp<UpdateOp, ValueT>;
+  constexpr static bool kTwoArgsUpdate_ =
+      !kOneArgUpdate_ && !std::is_same_v<UpdateOp, NoUpdateOp>;
+
+  // Values are only calculated if there are update operations.
+  using GetResult_ = std::conditional_t<std::is_same_v<UpdateOp, NoUpdateOp>,
+                                        const ValueT&, ValueT>;
+
+  using PendingPath_ = impl::PendingPath<UpdateOp, ValueT, UpdateArgT, KeyT>;
+
+ public:
+  /**
+   * @brief Construct a new Compact Dynamic Segment Tree object.
+   *
+   * @param begin beginning of a working area.
+   * @param end ending of a working area (not included).
+   * @param value default filling value.
+   * @param segGetComb functor called when two segments are combined in
+   * range get operation.
+   * @param segGetInit functor called for get result initialization on an
+   * equally filled segment.
+   * @param updateOp update operation.
+   * @param alloc allocator.
+   */
+  CompactDynamicSegmentTree(KeyT begin, KeyT end, const ValueT& value,
+                            const SegGetComb& segGetComb = SegGetComb{},
+                            const SegGetInit& segGetInit = SegGetInit{},
+                            const UpdateOp& updateOp = UpdateOp{},
+                            const Allocator& alloc = Allocator{});
+
+  /**
+   * @brief Construct a new Compact Dynamic Segment Tree object moving filling
+   * value.
+   *
+   * @param begin beginning of a working area.
+   * @param end ending of a working area (not included).
+   * @param value default filling value.
+   * @param segGetComb functor called when two segments are combined in
+   * range get operation.
+   * @param segGetInit functor called for get result initialization on an
+   * equally filled segment.
+   * @param updateOp update operation.
+   * @param alloc allocator.
+   */
+  CompactDynamicSegmentTree(KeyT begin, KeyT end, ValueT&& value = ValueT{},
+                            const SegGetComb& segGetComb = SegGetComb{},
+                            const SegGetInit& segGetInit = SegGetInit{},
+                            const UpdateOp& updateOp = UpdateOp{},
+                            const Allocator& alloc = Allocator{});
+
+  /**
+   * @brief Set value on a range.
+   *
+   * If `begin` >= `end`, then set operation range is perceived as empty and no
+   * changes happen.
+   *
+   * @param begin beginning of an updated segment.
+   * @param end ending of an updated segment (not included).
+   * @param toSet value to set.
+   */
+  void set(KeyT begin, KeyT end, const ValueT& toSet);
+
+  /**
+   * @brief Apply update operation with an argument on a range.
+   *
+   * @param begin beginning of an updated segment.
+   * @param end ending of an updated segment (not included).
+   * @param toUpdate argument for update operation.
+   */
+  template <class UpdateArgT1 = UpdateArgT>
+    requires conc::TwoArgsUpdateOp<UpdateOp, ValueT, UpdateArgT1>
+  void update(KeyT begin, KeyT end, const UpdateArgT1& toUpdate);
+
+  /**
+   * @brief Apply no arguments update operation on a range.
+   *
+   * @param begin beginning of an updated segment.
+   * @param end ending of an updated segment (not included).
+   */
+  void update(KeyT begin, KeyT end)
+    requires conc::OneArgUpdateOp<UpdateOp, ValueT>;
+
+  /**
+   * @brief Get value by index.
+   *
+   * @param key index.
+   * @return value in index. It is a copy with delayed updates applied if
+   * the tree has an update operation, and a reference otherwise.
+   */
+  GetResult_ get(KeyT key) const;
+
+  /**
+   * @brief Get result on a range.
+   *
+   * @param begin beginning of a range.
+   * @param end ending of a range.
+   * @return range get operation result.
+   */
+  GetValueT rangeGet(KeyT begin, KeyT end) const
+    requires conc::GetCombiner<SegGetComb, GetValueT, KeyT> &&
+             conc::GetInitializer<SegGetInit, ValueT, KeyT, GetValueT>;
+
+  /**
+   * @brief Number of nodes, which are currently used in the tree.
+   *
+   * @return nodes count.
+   */
+  [[nodiscard]] std::size_t nodesCount() const {
+    return nodes_.size() - 2 * freePairs_.size();
+  }
+
+ private:
+  void setImpl_(KeyT begin, KeyT end, KeyT currBegin, KeyT currEnd,
+                std::uint32_t currIdx, const ValueT& toSet);
+  template <class... UpdateArgs>
+  void updateImpl_(KeyT begin, KeyT end, KeyT currBegin, KeyT currEnd,
+                   std::uint32_t currIdx, const UpdateArgs&... toUpdate);
+  GetValueT rangeGetImpl_(KeyT begin, KeyT end, KeyT currBegin, KeyT currEnd,
+                          std::uint32_t currIdx, PendingPath_& path) const;
+
+  template <class... UpdateArgs>
+  void applyUpdate_(std::uint32_t idx, const UpdateArgs&... toUpdate);
+  void siftUpdate_(std::uint32_t idx);
+  void initChildren_(std::uint32_t idx);
+  void releaseChildren_(std::uint32_t idx);
+
+ private:
+  std::vector<Node_, NodeAlloc_> nodes_;
+  std::vector<std::uint32_t, IndexAlloc_> freePairs_;
+  [[no_unique_address]] UpdateOp updateOp_;
+  KeyT begin_;
+  KeyT end_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+CompactDynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                          UpdateOp, UpdateArgT, Allocator>::
+    CompactDynamicSegmentTree(KeyT begin, KeyT end, const ValueT& value,
+                              const SegGetComb& segGetComb,
+                              const SegGetInit& segGetInit,
+                              const UpdateOp& updateOp, const Allocator& alloc)
+    : RangeGetCombineVariationBase_(segGetComb),
+      RangeGetInitVariationBase_(segGetInit),
+      nodes_(NodeAlloc_(alloc)),
+      freePairs_(IndexAlloc_(alloc)),
+      updateOp_(updateOp),
+      begin_(begin),
+      end_(end) {
+  nodes_.push_back(Node_{value});
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+CompactDynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                          UpdateOp, UpdateArgT, Allocator>::
+    CompactDynamicSegmentTree(KeyT begin, KeyT end, ValueT&& value,
+                              const SegGetComb& segGetComb,
+                              const SegGetInit& segGetInit,
+                              const UpdateOp& updateOp, const Allocator& alloc)
+    : RangeGetCombineVariationBase_(segGetComb),
+      RangeGetInitVariationBase_(segGetInit),
+      nodes_(NodeAlloc_(alloc)),
+      freePairs_(IndexAlloc_(alloc)),
+      updateOp_(updateOp),
+      begin_(begin),
+      end_(end) {
+  nodes_.push_back(Node_{std::move(value)});
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+void CompactDynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                               UpdateOp, UpdateArgT,
+                               Allocator>::set(KeyT begin, KeyT end,
+                                               const ValueT& toSet) {
+  if (begin < end) {
+    setImpl_(begin, end, begin_, end_, 0, toSet);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+template <class UpdateArgT1>
+  requires conc::TwoArgsUpdateOp<UpdateOp, ValueT, UpdateArgT1>
+void CompactDynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                               UpdateOp, UpdateArgT,
+                               Allocator>::update(KeyT begin, KeyT end,
+                                                  const UpdateArgT1& toUpdate) {
+  updateImpl_(begin, end, begin_, end_, 0, toUpdate);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+void CompactDynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                               UpdateOp, UpdateArgT,
+                               Allocator>::update(KeyT begin, KeyT end)
+  requires conc::OneArgUpdateOp<UpdateOp, ValueT>
+{
+  updateImpl_(begin, end, begin_, end_, 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+auto CompactDynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb,
+                               SegGetInit, UpdateOp, UpdateArgT,
+                               Allocator>::get(KeyT key) const -> GetResult_ {
+  if (key >= end_ || key < begin_) {
+    std::stringstream messageStream;
+    messageStream << "Get operation for " << key << ", which is out of range.";
+    throw std::out_of_range(messageStream.str());
+  }
+  auto currBegin = begin_;
+  auto currEnd = end_;
+  auto path = PendingPath_{};
+  std::uint32_t currIdx = 0;
+  while (!nodes_[currIdx].isLeaf()) {
+    path.push(nodes_[currIdx]);
+    const auto mid = impl::midpoint(currBegin, currEnd);
+    if (key >= mid) {
+      currBegin = mid;
+      currIdx = nodes_[currIdx].children + 1;
+    } else {
+      currEnd = mid;
+      currIdx = nodes_[currIdx].children;
+    }
+  }
+  return path.apply(updateOp_, nodes_[currIdx].value);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+GetValueT
+CompactDynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                          UpdateOp, UpdateArgT,
+                          Allocator>::rangeGet(KeyT begin, KeyT end) const
+  requires conc::GetCombiner<SegGetComb, GetValueT, KeyT> &&
+           conc::GetInitializer<SegGetInit, ValueT, KeyT, GetValueT>
+{
+  auto path = PendingPath_{};
+  return rangeGetImpl_(begin, end, begin_, end_, 0, path);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+void CompactDynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                               UpdateOp, UpdateArgT, Allocator>::
+    setImpl_(KeyT begin, KeyT end, KeyT currBegin, KeyT currEnd,
+             std::uint32_t currIdx, const ValueT& toSet) {
+  assert(currBegin < end && "currBegin must be checked before call.");
+  assert(currEnd > begin && "currEnd must be checked before call.");
+  if (end >= currEnd && begin <= currBegin) {
+    releaseChildren_(currIdx);
+    nodes_[currIdx].value = toSet;
+    nodes_[currIdx].pending = Pending_{};
+    return;
+  }
+  if (nodes_[currIdx].isLeaf()) {
+    initChildren_(currIdx);
+  }
+  siftUpdate_(currIdx);
+  const auto mid = impl::midpoint(currBegin, currEnd);
+  const std::uint32_t leftIdx = nodes_[currIdx].children;
+  if (mid > begin) {
+    setImpl_(begin, end, currBegin, mid, leftIdx, toSet);
+  }
+  if (mid < end) {
+    setImpl_(begin, end, mid, currEnd, leftIdx + 1, toSet);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+template <class... UpdateArgs>
+void CompactDynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                               UpdateOp, UpdateArgT, Allocator>::
+    updateImpl_(KeyT begin, KeyT end, KeyT currBegin, KeyT currEnd,
+                std::uint32_t currIdx, const UpdateArgs&... toUpdate) {
+  if (begin >= currEnd || currBegin >= end) {
+    return;
+  }
+  if (end >= currEnd && begin <= currBegin) {
+    applyUpdate_(currIdx, toUpdate...);
+    return;
+  }
+  if (nodes_[currIdx].isLeaf()) {
+    initChildren_(currIdx);
+  }
+  siftUpdate_(currIdx);
+  const auto mid = impl::midpoint(currBegin, currEnd);
+  const std::uint32_t leftIdx = nodes_[currIdx].children;
+  updateImpl_(begin, end, currBegin, mid, leftIdx, toUpdate...);
+  updateImpl_(begin, end, mid, currEnd, leftIdx + 1, toUpdate...);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+GetValueT
+CompactDynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                          UpdateOp, UpdateArgT, Allocator>::
+    rangeGetImpl_(KeyT begin, KeyT end, KeyT currBegin, KeyT currEnd,
+                  std::uint32_t currIdx, PendingPath_& path) const {
+  const Node_& node = nodes_[currIdx];
+  if (node.isLeaf()) {
+    // Leaf segment is filled with one value, so there is no need to split it.
+    return RangeGetInitVariationBase_::initGet_(
+        std::max(currBegin, begin), std::min(currEnd, end),
+        path.apply(updateOp_, node.value));
+  }
+  const auto mid = impl::midpoint(currBegin, currEnd);
+  const std::uint32_t leftIdx = node.children;
+
+  path.push(node);
+  auto ret = [&]() -> GetValueT {
+    if (begin >= mid) {  // only right
+      return rangeGetImpl_(begin, end, mid, currEnd, leftIdx + 1, path);
+    }
+    if (end <= mid) {  // only left
+      return rangeGetImpl_(begin, end, currBegin, mid, leftIdx, path);
+    }
+    const GetValueT lVal =
+        rangeGetImpl_(begin, end, currBegin, mid, leftIdx, path);
+    const GetValueT rVal =
+        rangeGetImpl_(begin, end, mid, currEnd, leftIdx + 1, path);
+    return RangeGetCombineVariationBase_::combineGet_(
+        lVal, rVal, std::max(currBegin, begin), mid, std::min(currEnd, end));
+  }();
+  path.pop(node);
+  return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+template <class... UpdateArgs>
+void CompactDynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                               UpdateOp, UpdateArgT, Allocator>::
+    applyUpdate_(std::uint32_t idx, const UpdateArgs&... toUpdate) {
+  Node_& node = nodes_[idx];
+  if (node.isLeaf()) {
+    node.value = updateOp_(node.value, toUpdate...);
+    return;
+  }
+  if constexpr (kTwoArgsUpdate_) {
+    if (node.pending.has_value()) {
+      siftUpdate_(idx);
+    }
+    nodes_[idx].pending.emplace(toUpdate...);
+  } else {
+    impl::addPendingFlag<UpdateOp>(node.pending, [&] { siftUpdate_(idx); });
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+void CompactDynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                               UpdateOp, UpdateArgT,
+                               Allocator>::siftUpdate_(std::uint32_t idx) {
+  const std::uint32_t leftIdx = nodes_[idx].children;
+  if constexpr (kTwoArgsUpdate_) {
+    if (nodes_[idx].pending.has_value()) {
+      const UpdateArgT toUpdate = std::move(*nodes_[idx].pending);
+      nodes_[idx].pending.reset();
+      applyUpdate_(leftIdx, toUpdate);
+      applyUpdate_(leftIdx + 1, toUpdate);
+    }
+  } else if constexpr (kOneArgUpdate_) {
+    if (nodes_[idx].pending) {
+      nodes_[idx].pending = false;
+      applyUpdate_(leftIdx);
+      applyUpdate_(leftIdx + 1);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+void CompactDynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                               UpdateOp, UpdateArgT,
+                               Allocator>::initChildren_(std::uint32_t idx) {
+  assert(nodes_[idx].isLeaf() && "Can only init children for a leaf.");
+  std::uint32_t leftIdx = 0;
+  if (!freePairs_.empty()) {
+    leftIdx = freePairs_.back();
+    freePairs_.pop_back();
+    nodes_[leftIdx] = Node_{nodes_[idx].value};
+    nodes_[leftIdx + 1] = Node_{nodes_[idx].value};
+  } else {
+    if (nodes_.size() > std::numeric_limits<std::uint32_t>::max() - 2) {
+      throw std::length_error("Compact segment tree nodes count overflow.");
+    }
+    leftIdx = static_cast<std::uint32_t>(nodes_.size());
+    if (nodes_.capacity() - nodes_.size() < 2) {
+      // Both children are added after one reallocation, so a failed one
+      // leaves no unpaired node. Capacity grows geometrically.
+      nodes_.reserve(std::max(2 * nodes_.capacity(), nodes_.size() + 2));
+    }
+    nodes_.push_back(Node_{nodes_[idx].value});
+    nodes_.push_back(Node_{nodes_[idx].value});
+  }
+  nodes_[idx].children = leftIdx;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+void CompactDynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                               UpdateOp, UpdateArgT,
+                               Allocator>::releaseChildren_(std::uint32_t idx) {
+  const std::uint32_t leftIdx = nodes_[idx].children;
+  if (leftIdx == 0) {
+    return;
+  }
+  releaseChildren_(leftIdx);
+  releaseChildren_(leftIdx + 1);
+  freePairs_.push_back(leftIdx);
+  nodes_[idx].children = 0;
+}
+
+}  // namespace dst
+
+#endif  // COMPACT_DYNAMIC_SEGMENT_TREE_HPP
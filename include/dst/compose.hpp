@@ -0,0 +1,41 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright Georgy Guminov 2023-2024.
+// Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt
+// or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef COMPOSE_HPP
+#define COMPOSE_HPP
+
+namespace dst::compose {
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief The Sum<UpdateArgT> class. Composition of two additions.
+///
+/// \tparam UpdateArgT update operation argument type.
+///
+template <class UpdateArgT>
+struct Sum {
+  UpdateArgT operator()(const UpdateArgT& first,
+                        const UpdateArgT& second) const {
+    return first + second;
+  }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief The Last<UpdateArgT> class. Composition of two assignments, where
+/// the second one overrides the first.
+///
+/// \tparam UpdateArgT update operation argument type.
+///
+template <class UpdateArgT>
+struct Last {
+  UpdateArgT operator()(const UpdateArgT& /*first*/,
+                        const UpdateArgT& second) const {
+    return second;
+  }
+};
+
+}  // namespace dst::compose
+
+#endif  // COMPOSE_HPP
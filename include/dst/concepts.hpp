@@ -9,6 +9,12 @@
 
 #include <concepts>
 #include <dst/disable_operations.hpp>
+#include <dst/policies.hpp>
+#include <dst/serialization.hpp>
+#include <istream>
+#include <ostream>
+#include <ranges>
+#include <tuple>
 
 namespace dst::conc {
 
@@ -75,6 +81,42 @@ template <class T, class ValueT, class UpdateArgT>
 concept UpdateOp =
     OneArgUpdateOp<T, ValueT> || TwoArgsUpdateOp<T, ValueT, UpdateArgT>;
 
+////////////////////////////////////////////////////////////////////////////////
+// Update composition concepts.                                               //
+////////////////////////////////////////////////////////////////////////////////
+template <class T, class UpdateArgT>
+concept UpdateCompose = requires(const T& compose, const UpdateArgT& first,
+                                 const UpdateArgT& second) {
+                          {
+                            compose(first, second)
+                            } -> std::convertible_to<UpdateArgT>;
+                        };
+
+////////////////////////////////////////////////////////////////////////////////
+// Cache update operations concepts.                                          //
+////////////////////////////////////////////////////////////////////////////////
+template <class T, class GetValueT, class KeyT>
+concept OneArgCacheUpdateOp =
+    requires(const T& operation, const GetValueT& cached, KeyT begin,
+             KeyT end) {
+      { operation(cached, begin, end) } -> std::convertible_to<GetValueT>;
+    };
+
+template <class T, class GetValueT, class UpdateArgT, class KeyT>
+concept TwoArgsCacheUpdateOp =
+    requires(const T& operation, const GetValueT& cached,
+             const UpdateArgT& updateArg, KeyT begin, KeyT end) {
+      {
+        operation(cached, updateArg, begin, end)
+        } -> std::convertible_to<GetValueT>;
+    };
+
+template <class T, class GetValueT, class UpdateArgT, class KeyT>
+concept CacheUpdateOp =
+    (std::is_void_v<UpdateArgT> && OneArgCacheUpdateOp<T, GetValueT, KeyT>) ||
+    (!std::is_void_v<UpdateArgT> &&
+     TwoArgsCacheUpdateOp<T, GetValueT, UpdateArgT, KeyT>);
+
 ////////////////////////////////////////////////////////////////////////////////
 // Optional parameters concepts.                                              //
 ////////////////////////////////////////////////////////////////////////////////
@@ -90,6 +132,72 @@ template <class T, class ValueT, class UpdateArgT>
 concept OptUpdateOp =
     UpdateOp<T, ValueT, UpdateArgT> || std::is_same_v<T, NoUpdateOp>;
 
+template <class T, class ValueT, class UpdateOp, class UpdateArgT>
+concept OptUpdateCompose =
+    std::is_same_v<T, NoUpdateCompose> ||
+    (TwoArgsUpdateOp<UpdateOp, ValueT, UpdateArgT> &&
+     UpdateCompose<T, UpdateArgT>);
+
+////////////////////////////////////////////////////////////////////////////////
+// Allocator concepts.                                                        //
+////////////////////////////////////////////////////////////////////////////////
+template <class T>
+concept BulkReleaseAllocator = requires(T& allocator) {
+  { allocator.clearIfExclusive() } -> std::same_as<bool>;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Construction concepts.                                                     //
+////////////////////////////////////////////////////////////////////////////////
+template <class T, class KeyT, class ValueT>
+concept LeafRunRange =
+    std::ranges::input_range<const T> &&
+    requires(std::ranges::range_reference_t<const T> run) {
+      { std::get<0>(run) } -> std::convertible_to<KeyT>;
+      { std::get<1>(run) } -> std::convertible_to<KeyT>;
+      { std::get<2>(run) } -> std::convertible_to<const ValueT&>;
+    };
+
+////////////////////////////////////////////////////////////////////////////////
+// Serialization concepts.                                                    //
+////////////////////////////////////////////////////////////////////////////////
+template <class T>
+concept Serializable =
+    requires(std::ostream& out, std::istream& in, const T& value) {
+      Serializer<T>::write(out, value);
+      { Serializer<T>::read(in) } -> std::same_as<T>;
+    };
+
+template <class T>
+concept OptSerializable = std::is_void_v<T> || Serializable<T>;
+
+////////////////////////////////////////////////////////////////////////////////
+// Policies concepts.                                                         //
+////////////////////////////////////////////////////////////////////////////////
+template <class T, class UpdateOp, class GetValueT, class UpdateArgT,
+          class KeyT>
+concept RangeGetCacheUpdate =
+    (std::is_same_v<T, RangeGetCache> &&
+     std::is_same_v<UpdateOp, NoUpdateOp>) ||
+    (requires { typename T::Op; } &&
+     std::is_same_v<T, RangeGetCacheWithUpdate<typename T::Op>> &&
+     !std::is_same_v<UpdateOp, NoUpdateOp> &&
+     CacheUpdateOp<typename T::Op, GetValueT, UpdateArgT, KeyT>);
+
+template <class T, class KeyT, class GetValueT, class SegGetComb,
+          class SegGetInit, class UpdateOp, class UpdateArgT>
+concept RangeGetCachePolicy =
+    std::is_same_v<T, NoRangeGetCache> ||
+    (!std::is_same_v<SegGetComb, NoRangeGetOp> &&
+     !std::is_same_v<SegGetInit, NoRangeGetOp> &&
+     RangeGetCacheUpdate<T, UpdateOp, GetValueT, UpdateArgT, KeyT>);
+
+template <class T, class ValueT>
+concept LeafCoalescePolicy =
+    std::is_same_v<T, NoLeafCoalescing> ||
+    (std::is_same_v<T, CoalesceEqualLeaves> &&
+     std::equality_comparable<ValueT>);
+
 }  // namespace dst::conc
 
 #endif  // CONCEPTS_HPP
@@ -13,6 +13,8 @@ struct NoRangeGetOp {};
 
 struct NoUpdateOp {};
 
+struct NoUpdateCompose {};
+
 }  // namespace dst
 
 #endif  // DISABLE_OPERATIONS_HPP
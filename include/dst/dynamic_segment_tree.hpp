@@ -8,16 +8,33 @@
 #define DYNAMIC_SEGMENT_TREE_HPP
 
 #include <algorithm>
+#include <array>
 #include <concepts>
+#include <cstddef>
+#include <dst/comb.hpp>
 #include <dst/concepts.hpp>
 #include <dst/disable_operations.hpp>
 #include <dst/impl/dynamic_segment_tree_range_get_variation_base.hpp>
 #include <dst/impl/dynamic_segment_tree_update_variation_base.hpp>
 #include <dst/impl/node.hpp>
+#include <dst/key_range.hpp>
 #include <dst/mp.hpp>
+#include <dst/policies.hpp>
+#include <dst/serialization.hpp>
+#include <functional>
+#include <istream>
+#include <iterator>
+#include <limits>
 #include <memory>
+#include <optional>
+#include <ostream>
+#include <ranges>
+#include <span>
 #include <sstream>
 #include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 namespace dst {
 
@@ -46,25 +63,51 @@ namespace dst {
 /// \tparam UpdateArgT an argument for update operation. Used only for the
 /// second form of UpdateOp functor. In other cases this parameter is ignored.
 /// \tparam Allocator allocator for nodes of a dynamic segment tree.
+/// \tparam GetCachePolicy NoRangeGetCache, RangeGetCache (trees without
+/// update operation) or RangeGetCacheWithUpdate (trees with update
+/// operation). In the last two cases internal nodes store rangeGet results of
+/// their segments, so fully covered subtrees are not traversed in rangeGet
+/// operation.
+/// \tparam UpdateCompose composition of two update arguments for the second
+/// form of UpdateOp functor, or NoUpdateCompose. It must satisfy
+/// `updateOp(updateOp(v, first), second) == updateOp(v, updateCompose(first,
+/// second))`. If it is set, a delayed update is merged with a new one in
+/// place, so update operation never pushes updates down a subtree.
+/// \tparam CoalescePolicy NoLeafCoalescing or CoalesceEqualLeaves. In the
+/// second case two sibling leaves with equal values are merged into their
+/// parent after set and update operations. ValueT must be equality comparable.
+///
+/// Const operations never modify a tree: delayed updates are applied on the
+/// fly to the values they return. So one tree can be queried from several
+/// threads at once without locks, while no thread modifies it.
 template <std::integral KeyT, class ValueT, class GetValueT,
           conc::OptGetCombiner<GetValueT, KeyT> SegGetComb = NoRangeGetOp,
           conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit =
               NoRangeGetOp,
           class UpdateOp = NoUpdateOp,
           class UpdateArgT = mp::DefaultUpdateArgT<UpdateOp, ValueT>,
-          class Allocator = std::allocator<ValueT>>
+          class Allocator = std::allocator<ValueT>,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy =
+              NoRangeGetCache,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose =
+              NoUpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy = NoLeafCoalescing>
   requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
 class DynamicSegmentTree
     : public impl::DynamicSegmentTreeUpdateVariationBase<
           DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
-                             UpdateOp, UpdateArgT, Allocator>>,
+                             UpdateOp, UpdateArgT, Allocator, GetCachePolicy,
+                             UpdateCompose, CoalescePolicy>>,
       protected impl::DynamicSegmentTreeRangeGetCombineVariationBase<
           KeyT, GetValueT, SegGetComb>,
       protected impl::DynamicSegmentTreeRangeGetInitVariationBase<
           KeyT, ValueT, GetValueT, SegGetInit> {
  private:
-  using This_ = DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb,
-                                   SegGetInit, UpdateOp, UpdateArgT, Allocator>;
+  using This_ =
+      DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                         UpdateOp, UpdateArgT, Allocator, GetCachePolicy,
+                         UpdateCompose, CoalescePolicy>;
 
   using UpdateVariationBase_ =
       impl::DynamicSegmentTreeUpdateVariationBase<This_>;
@@ -82,6 +125,52 @@ class DynamicSegmentTree
   using NodeAlloc_ =
       std::allocator_traits<Allocator>::template rebind_alloc<Node_>;
 
+  constexpr static bool kCacheRangeGet_ =
+      !std::is_same_v<GetCachePolicy, NoRangeGetCache>;
+  constexpr static bool kCoalesceLeaves_ =
+      std::is_same_v<CoalescePolicy, CoalesceEqualLeaves>;
+
+  // Nodes can be dropped without destructors calls.
+  constexpr static bool kTriviallyDestructibleNodes_ =
+      std::is_trivially_destructible_v<ValueT> &&
+      (std::is_void_v<UpdateArgT> ||
+       std::is_trivially_destructible_v<UpdateArgT>) &&
+      (!kCacheRangeGet_ || std::is_trivially_destructible_v<GetValueT>);
+
+  using PendingPath_ = UpdateVariationBase_::PendingPath_;
+
+  // Values with delayed updates on their path are calculated, so they can not
+  // be returned by reference.
+  using GetResult_ = std::conditional_t<std::is_same_v<UpdateOp, NoUpdateOp>,
+                                        const ValueT&, ValueT>;
+
+  // An internal node on a path from the root and its segment.
+  struct PathFrame_ {
+    const Node_* node;
+    KeyT begin;
+    KeyT end;
+  };
+
+  constexpr static std::size_t kMaxDepth_ =
+      std::numeric_limits<std::make_unsigned_t<KeyT>>::digits;
+
+  // An internal node, which children are changed, and its segment.
+  struct SetFrame_ {
+    Node_* node;
+    KeyT begin;
+    KeyT end;
+  };
+
+  // Cached range get results are minimums (maximums) of values, so they bound
+  // the extreme of a subtree.
+  template <class Compare>
+  constexpr static bool kCachedExtreme_ =
+      kCacheRangeGet_ && std::is_same_v<GetValueT, ValueT> &&
+      ((std::is_same_v<Compare, std::less<>> &&
+        std::is_same_v<SegGetComb, comb::Min<ValueT>>) ||
+       (std::is_same_v<Compare, std::greater<>> &&
+        std::is_same_v<SegGetComb, comb::Max<ValueT>>));
+
  public:
   /**
    * @brief Construct a new Dynamic Segment Tree object making a copy of
@@ -156,6 +245,75 @@ class DynamicSegmentTree
                      const UpdateOp& updateOp = UpdateOp{},
                      const Allocator& alloc = Allocator{});
 
+  /**
+   * @brief Construct a new Dynamic Segment Tree object over all keys of KeyT.
+   *
+   * The root segment is [min, max), and the value of the maximal key is kept
+   * out of nodes. A range, which ends with the minimal key, wraps past the
+   * maximal key and includes it: [k, min) is [k, max], and [min, min) is the
+   * whole key type. Combiners and initializers get (max, min) as the segment
+   * of the maximal key, so ones, which use borders, must count lengths modulo
+   * 2^N, as impl::keyDistance does.
+   *
+   * @param value default filling value.
+   * @param segGetComb functor called when two segments are combined in
+   * range get operation.
+   * @param segGetInit functor called for get result initialization on an
+   * equally filled segment.
+   * @param updateOp update operation.
+   * @param alloc allocator.
+   */
+  DynamicSegmentTree(FullKeyRange, const ValueT& value,
+                     const SegGetComb& segGetComb = SegGetComb{},
+                     const SegGetInit& segGetInit = SegGetInit{},
+                     const UpdateOp& updateOp = UpdateOp{},
+                     const Allocator& alloc = Allocator{});
+
+  /**
+   * @brief Construct a new Dynamic Segment Tree object over all keys of KeyT
+   * moving filling value. Ranges are as in the constructor above.
+   *
+   * @param value default filling value.
+   * @param segGetComb functor called when two segments are combined in
+   * range get operation.
+   * @param segGetInit functor called for get result initialization on an
+   * equally filled segment.
+   * @param updateOp update operation.
+   * @param alloc allocator.
+   */
+  explicit DynamicSegmentTree(FullKeyRange, ValueT&& value = ValueT{},
+                              const SegGetComb& segGetComb = SegGetComb{},
+                              const SegGetInit& segGetInit = SegGetInit{},
+                              const UpdateOp& updateOp = UpdateOp{},
+                              const Allocator& alloc = Allocator{});
+
+  /**
+   * @brief Construct a new Dynamic Segment Tree object from runs of equal
+   * values.
+   *
+   * Nodes are built in one pass over the runs, without traversals from the
+   * root for every run. Keys, which are not covered by runs, get `value`.
+   *
+   * @param begin beginning of a working area.
+   * @param end ending of a working area (not included).
+   * @param runs (begin, end, value) tuples sorted by beginning. Runs must not
+   * overlap. Empty runs are ignored.
+   * @param value filling value for keys out of runs.
+   * @param segGetComb functor called when two segments are combined in
+   * range get operation.
+   * @param segGetInit functor called for get result initialization on an
+   * equally filled segment.
+   * @param updateOp update operation.
+   * @param alloc allocator.
+   */
+  template <conc::LeafRunRange<KeyT, ValueT> Runs>
+  DynamicSegmentTree(KeyT begin, KeyT end, const Runs& runs,
+                     const ValueT& value = ValueT{},
+                     const SegGetComb& segGetComb = SegGetComb{},
+                     const SegGetInit& segGetInit = SegGetInit{},
+                     const UpdateOp& updateOp = UpdateOp{},
+                     const Allocator& alloc = Allocator{});
+
   /**
    * @brief Copy assign operator. Makes a full copy of a dynamic segment tree.
    *
@@ -189,6 +347,27 @@ class DynamicSegmentTree
    */
   // void update(KeyT begin, KeyT end)
 
+  /**
+   * @brief Apply one argument operation on a range and get result on the
+   * range after it in the same descent.
+   *
+   * @param begin beginning of an updated segment.
+   * @param end ending of an updated segment (not included).
+   * @param toUpdate argument for update operation.
+   * @return range get operation result after the update.
+   */
+  // GetValueT updateAndGet(KeyT begin, KeyT end, const UpdateArgT& toUpdate);
+
+  /**
+   * @brief Apply no arguments update operation on a range and get result on
+   * the range after it in the same descent.
+   *
+   * @param begin beginning of an updated segment.
+   * @param end ending of an updated segment (not included).
+   * @return range get operation result after the update.
+   */
+  // GetValueT updateAndGet(KeyT begin, KeyT end);
+
   /**
    * @brief Set value on a range.
    *
@@ -213,13 +392,148 @@ class DynamicSegmentTree
    */
   void set(KeyT begin, KeyT end, ValueT&& toSet);
 
+  /**
+   * @brief Set value on a range and get result on the range before it in the
+   * same descent. Subtrees, which are replaced, are freed.
+   *
+   * @param begin beginning of an updated segment.
+   * @param end ending of an updated segment (not included).
+   * @param toSet value to set.
+   * @return range get operation result before the set.
+   * @throws std::out_of_range if a range has no keys of a working area.
+   */
+  GetValueT exchange(KeyT begin, KeyT end, const ValueT& toSet)
+    requires conc::GetCombiner<SegGetComb, GetValueT, KeyT> &&
+             conc::GetInitializer<SegGetInit, ValueT, KeyT, GetValueT>;
+
+  /**
+   * @brief Set values on several ranges in one traversal.
+   *
+   * The result is the same as of calling set for each operation in order, so
+   * where ranges overlap, a later operation wins. Operations with empty ranges
+   * are ignored. Upper levels of the tree are visited once for the whole
+   * batch, so it is faster for many operations sorted by range beginning.
+   *
+   * @param toSet (begin, end, value) set operations.
+   */
+  void setBatch(std::span<const std::tuple<KeyT, KeyT, ValueT>> toSet);
+
   /**
    * @brief Get value by index.
    *
    * @param key index.
-   * @return value in index.
+   * @return value in index. It is a copy with delayed updates applied if
+   * the tree has an update operation, and a reference otherwise.
+   */
+  GetResult_ get(KeyT key) const;
+
+  /**
+   * @brief Get values by several indices.
+   *
+   * Each descent starts from the deepest common ancestor of the previous and
+   * the current key instead of the root. So for sorted keys the number of
+   * visited nodes is about O(k + log n) instead of O(k log n).
+   *
+   * @param keys indices.
+   * @param out output iterator, values are written to.
+   * @return output iterator after the last written value.
+   */
+  template <std::output_iterator<const ValueT&> OutputIt>
+  OutputIt getMany(std::span<const KeyT> keys, OutputIt out) const;
+
+  /**
+   * @brief A leaf segment [begin, end) filled with one value.
+   */
+  struct LeafRun {
+    KeyT begin;
+    KeyT end;
+    const ValueT& value;
+  };
+
+  ////////////////////////////////////////////////////////////////////////////
+  /// \brief Forward iterator over leaves of a tree in key order.
+  ///
+  /// Pending updates are applied to values on the fly. For trees with an
+  /// update operation a value reference is valid until the iterator is
+  /// incremented or destroyed. Any modification of the tree invalidates
+  /// iterators.
+  class LeafIterator {
+   public:
+    using value_type = LeafRun;
+    using difference_type = std::ptrdiff_t;
+
+   public:
+    LeafIterator() = default;
+
+    LeafRun operator*() const {
+      if (atLastKey_) {
+        return {leafBegin_, leafEnd_, *tree_->lastKey_};
+      }
+      if constexpr (std::is_same_v<UpdateOp, NoUpdateOp>) {
+        return {leafBegin_, leafEnd_, leaf_->getValue()};
+      } else {
+        return {leafBegin_, leafEnd_, *value_};
+      }
+    }
+
+    LeafIterator& operator++();
+
+    LeafIterator operator++(int) {
+      auto ret = *this;
+      ++*this;
+      return ret;
+    }
+
+    bool operator==(const LeafIterator& other) const {
+      return leaf_ == other.leaf_ && atLastKey_ == other.atLastKey_;
+    }
+
+    bool operator==(std::default_sentinel_t /*sentinel*/) const {
+      return leaf_ == nullptr && !atLastKey_;
+    }
+
+   private:
+    explicit LeafIterator(const DynamicSegmentTree* tree) : tree_(tree) {
+      // A tree with an empty working area starts at the end.
+      if (tree->begin_ < tree->end_) {
+        descend_(&tree->rootNode_, tree->begin_, tree->end_);
+      }
+    }
+
+    void descend_(const Node_* node, KeyT nodeBegin, KeyT nodeEnd);
+
+   private:
+    const DynamicSegmentTree* tree_{nullptr};
+    // Internal nodes from the root down to the current leaf.
+    std::array<PathFrame_, kMaxDepth_> path_{};
+    std::size_t depth_{0};
+    PendingPath_ pending_{};
+    const Node_* leaf_{nullptr};
+    // The maximal key of a tree over all keys is a run [max, min) after the
+    // leaves.
+    bool atLastKey_{false};
+    KeyT leafBegin_{};
+    KeyT leafEnd_{};
+    // Value of the current leaf with pending updates applied.
+    [[no_unique_address]] std::conditional_t<
+        std::is_same_v<UpdateOp, NoUpdateOp>, std::tuple<>,
+        std::optional<ValueT>> value_;
+
+   private:
+    friend class DynamicSegmentTree;
+  };
+
+  /**
+   * @brief Leaves of a tree in key order as (begin, end, value) runs.
+   *
+   * Iteration costs O(leaves) rather than O(keys). Equal neighbour leaves are
+   * not merged. A tree with an empty working area has no leaves.
+   *
+   * @return range of leaves.
    */
-  const ValueT& get(KeyT key) const;
+  std::ranges::subrange<LeafIterator, std::default_sentinel_t> leaves() const {
+    return {LeafIterator(this), std::default_sentinel};
+  }
 
   /**
    * @brief Get result on a range.
@@ -232,26 +546,234 @@ class DynamicSegmentTree
     requires conc::GetCombiner<SegGetComb, GetValueT, KeyT> &&
              conc::GetInitializer<SegGetInit, ValueT, KeyT, GetValueT>;
 
+  /**
+   * @brief Get results on several ranges in one traversal.
+   *
+   * Every node is visited once for all ranges touching it. A result of a
+   * subtree, which is fully covered by several ranges, is calculated once.
+   * Parts of a range are combined from left to right, so a segments combiner
+   * must be associative.
+   *
+   * @param ranges (begin, end) ranges. Parts out of a working area are
+   * ignored, as in rangeGet.
+   * @param out results, out[i] is a result on ranges[i]. Previous values are
+   * overwritten.
+   * @throws std::invalid_argument if `out` is shorter than `ranges`.
+   */
+  void rangeGetBatch(std::span<const std::pair<KeyT, KeyT>> ranges,
+                     std::span<GetValueT> out) const
+    requires conc::GetCombiner<SegGetComb, GetValueT, KeyT> &&
+             conc::GetInitializer<SegGetInit, ValueT, KeyT, GetValueT>;
+
+  /**
+   * @brief Find the first key `k` in a range, such that a predicate is true on
+   * rangeGet result on [begin, k + 1).
+   *
+   * The predicate must be monotone: once it is true on a prefix of the range,
+   * it must be true on all longer prefixes. The search descends once.
+   * Subtrees, which do not make the predicate true, are skipped by their
+   * cached results with `RangeGetCache` or `RangeGetCacheWithUpdate`, so the
+   * search takes O(log n) combiner calls. Delayed updates met on the way are
+   * applied to cached results. Without a cache skipped subtrees are traversed
+   * as in rangeGet. The key inside a leaf is found by a binary search over
+   * `SegGetInit` results.
+   *
+   * @param begin beginning of a range.
+   * @param end ending of a range.
+   * @param pred predicate on rangeGet results.
+   * @return first key, or std::nullopt if the predicate is false on the whole
+   * range.
+   */
+  template <std::predicate<const GetValueT&> Pred>
+  std::optional<KeyT> findFirst(KeyT begin, KeyT end, Pred pred) const
+    requires conc::GetCombiner<SegGetComb, GetValueT, KeyT> &&
+             conc::GetInitializer<SegGetInit, ValueT, KeyT, GetValueT>;
+
+  /**
+   * @brief Find the first key `k`, such that rangeGet result on a prefix of a
+   * working area [begin, k + 1) is not less than `target`. For example, the
+   * first key where a prefix sum of non-negative values reaches `target`.
+   *
+   * @param target target value.
+   * @return first key, or std::nullopt if rangeGet result on the whole working
+   * area is less than `target`.
+   */
+  template <std::totally_ordered_with<GetValueT> TargetT>
+  std::optional<KeyT> lowerBoundPrefix(const TargetT& target) const
+    requires conc::GetCombiner<SegGetComb, GetValueT, KeyT> &&
+             conc::GetInitializer<SegGetInit, ValueT, KeyT, GetValueT>;
+
+  /**
+   * @brief Find a key of the k-th unit of a counting tree: the first key,
+   * where a prefix result of a working area is greater than `k`.
+   *
+   * Values must be non-negative counts, rangeGet result must be their sum.
+   * Same descent as in findFirst.
+   *
+   * @param k zero-based unit index.
+   * @return key of the unit, or std::nullopt if there are not more than `k`
+   * units in a tree.
+   */
+  template <std::totally_ordered_with<GetValueT> CountT>
+  std::optional<KeyT> kth(const CountT& k) const
+    requires conc::GetCombiner<SegGetComb, GetValueT, KeyT> &&
+             conc::GetInitializer<SegGetInit, ValueT, KeyT, GetValueT>;
+
+  /**
+   * @brief Get the leftmost key with the minimal value on a range.
+   *
+   * The key is tracked in the same traversal as the value. With a cached
+   * min tree (`RangeGetCache` or `RangeGetCacheWithUpdate`) subtrees, which
+   * can not contain a smaller value, are skipped by their cached results.
+   *
+   * @param begin beginning of a range.
+   * @param end ending of a range.
+   * @return (key, value) pair.
+   * @throws std::out_of_range if a range has no keys of a working area.
+   */
+  std::pair<KeyT, ValueT> rangeArgMin(KeyT begin, KeyT end) const
+    requires std::totally_ordered<ValueT>;
+
+  /**
+   * @brief Get the leftmost key with the maximal value on a range.
+   *
+   * Same as rangeArgMin, but subtrees are skipped on a cached max tree.
+   *
+   * @param begin beginning of a range.
+   * @param end ending of a range.
+   * @return (key, value) pair.
+   * @throws std::out_of_range if a range has no keys of a working area.
+   */
+  std::pair<KeyT, ValueT> rangeArgMax(KeyT begin, KeyT end) const
+    requires std::totally_ordered<ValueT>;
+
+  /**
+   * @brief Write a tree in a binary form.
+   *
+   * Node shape and delayed update flags are written as preorder bitstreams,
+   * followed by leaf values and delayed update arguments in postorder, and the
+   * value of the maximal key of a tree over all keys.
+   * Values and update arguments are written with dst::Serializer.
+   *
+   * @param out output stream.
+   */
+  void serialize(std::ostream& out) const
+    requires conc::Serializable<KeyT> && conc::Serializable<ValueT> &&
+             conc::OptSerializable<UpdateArgT>;
+
+  /**
+   * @brief Read a tree written by serialize.
+   *
+   * @param in input stream.
+   * @param segGetComb functor called when two segments are combined in
+   * range get operation.
+   * @param segGetInit functor called for get result initialization on an
+   * equally filled segment.
+   * @param updateOp update operation.
+   * @param alloc allocator.
+   * @return read tree.
+   * @throws std::runtime_error if the stream does not contain a valid tree.
+   */
+  static DynamicSegmentTree deserialize(
+      std::istream& in, const SegGetComb& segGetComb = SegGetComb{},
+      const SegGetInit& segGetInit = SegGetInit{},
+      const UpdateOp& updateOp = UpdateOp{},
+      const Allocator& alloc = Allocator{})
+    requires conc::Serializable<KeyT> && conc::Serializable<ValueT> &&
+             conc::OptSerializable<UpdateArgT>;
+
   /**
    * @brief Destroy the Dynamic Segment Tree object
    */
   ~DynamicSegmentTree();
 
+ protected:
+  /**
+   * @brief Get value by index in a tree, which working area length is a power
+   * of two. Segments of all nodes are halved evenly, so a child is chosen by
+   * one bit of a key offset without calculation of segment borders.
+   *
+   * @param offset key offset from the beginning of a working area.
+   * @param half half of a working area length.
+   * @return value in index.
+   */
+  GetResult_ getByOffsetBits_(std::make_unsigned_t<KeyT> offset,
+                              std::make_unsigned_t<KeyT> half) const;
+  [[noreturn]] static void throwGetOutOfRange_(KeyT key);
+
  private:
   template <class ValueT1>
     requires std::is_same_v<std::remove_cvref_t<ValueT1>, ValueT>
   void setImpl_(KeyT begin, KeyT end, KeyT currBegin, KeyT currEnd,
                 Node_* currNode, ValueT1&& toUpdate);
-  const ValueT& getImpl_(KeyT key, KeyT currBegin, KeyT currEnd,
-                         Node_* currNode) const;
+  template <class RunIt, class RunSentinel>
+  void buildFromRuns_(KeyT currBegin, KeyT currEnd, Node_* currNode,
+                      RunIt& runIt, const RunSentinel& runsEnd);
+  void setBatchImpl_(std::span<const std::tuple<KeyT, KeyT, ValueT>> toSet,
+                     std::vector<std::size_t>& opIndices, std::size_t first,
+                     KeyT currBegin, KeyT currEnd, Node_* currNode);
   GetValueT rangeGetImpl_(KeyT begin, KeyT end, KeyT currBegin, KeyT currEnd,
-                          Node_* currNode) const;
+                          const Node_* currNode, PendingPath_& pending) const;
+  void rangeGetBatchImpl_(std::span<const std::pair<KeyT, KeyT>> ranges,
+                          std::span<GetValueT> out,
+                          std::vector<std::size_t>& rangeIndices,
+                          std::size_t first, KeyT currBegin, KeyT currEnd,
+                          const Node_* currNode, PendingPath_& pending) const;
+  template <class Compare>
+  std::pair<KeyT, ValueT> rangeArgExtreme_(KeyT begin, KeyT end) const;
+  template <class Compare>
+  void rangeArgExtremeImpl_(KeyT begin, KeyT end, KeyT currBegin, KeyT currEnd,
+                            const Node_* currNode,
+                            std::optional<std::pair<KeyT, ValueT>>& best,
+                            PendingPath_& pending) const;
+  template <class ModifyCovered, class ModifyLastKey>
+  GetValueT modifyAndGet_(KeyT begin, KeyT end, const ModifyCovered& modify,
+                          const ModifyLastKey& modifyLastKey);
+  template <class ModifyCovered>
+  GetValueT modifyAndGetImpl_(KeyT begin, KeyT end, KeyT currBegin,
+                              KeyT currEnd, Node_* currNode,
+                              const ModifyCovered& modify);
+  template <class Pred>
+  std::optional<KeyT> findFirstImpl_(KeyT begin, KeyT end, KeyT currBegin,
+                                     KeyT currEnd, const Node_* currNode,
+                                     Pred& pred, std::optional<GetValueT>& acc,
+                                     PendingPath_& pending) const;
+  void afterChildrenChanged_(Node_* currNode, KeyT currBegin, KeyT mid,
+                             KeyT currEnd);
+  void collectShape_(const Node_* currNode, std::vector<bool>& internal,
+                     std::vector<bool>& pending) const;
+  void writeNodes_(const Node_* currNode, std::ostream& out) const;
+  void readNodes_(std::istream& in, const std::vector<bool>& internal,
+                  const std::vector<bool>& pending, std::size_t& nodeIdx,
+                  KeyT currBegin, KeyT currEnd, Node_* currNode,
+                  bool leftmost);
+  void optionalRecalcNodeGetCache_(Node_* currNode, KeyT currBegin, KeyT mid,
+                                   KeyT currEnd) const;
+
+  // In a tree over all keys a range, which ends with the minimal key, wraps
+  // past the maximal one.
+  bool reachesLastKey_(KeyT end) const {
+    return lastKey_.has_value() && end == std::numeric_limits<KeyT>::min();
+  }
+  // End of the part of a range in the root segment.
+  KeyT rootEnd_(KeyT end) const { return reachesLastKey_(end) ? end_ : end; }
+  // End of a whole working area as a range ending.
+  KeyT areaEnd_() const {
+    return lastKey_.has_value() ? std::numeric_limits<KeyT>::min() : end_;
+  }
+  GetValueT lastKeyGet_() const {
+    return RangeGetInitVariationBase_::initGet_(
+        end_, std::numeric_limits<KeyT>::min(), *lastKey_);
+  }
 
  private:
-  mutable NodeAlloc_ nodeAllocator_;
-  mutable Node_ rootNode_;
+  NodeAlloc_ nodeAllocator_;
+  Node_ rootNode_;
   KeyT begin_;
   KeyT end_;
+  // Value of the maximal key in a tree over all keys. The key does not fit the
+  // root segment [min, max), so it is kept out of nodes.
+  std::optional<ValueT> lastKey_;
 
  private:
   friend class impl::DynamicSegmentTreeUpdateVariationBase<This_>;
@@ -261,15 +783,21 @@ class DynamicSegmentTree
 template <std::integral KeyT, class ValueT, class GetValueT,
           conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
           conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
-          class UpdateOp, class UpdateArgT, class Allocator>
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
   requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
-DynamicSegmentTree<
-    KeyT, ValueT, GetValueT, SegGetComb, SegGetInit, UpdateOp, UpdateArgT,
-    Allocator>::DynamicSegmentTree(const DynamicSegmentTree& other)
+DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit, UpdateOp,
+                   UpdateArgT, Allocator, GetCachePolicy, UpdateCompose,
+                   CoalescePolicy>::
+    DynamicSegmentTree(const DynamicSegmentTree& other)
     : nodeAllocator_(other.nodeAllocator_),
       rootNode_(other.rootNode_, nodeAllocator_),
       begin_(other.begin_),
       end_(other.end_),
+      lastKey_(other.lastKey_),
       RangeGetInitVariationBase_(other),
       RangeGetCombineVariationBase_(other),
       UpdateVariationBase_(other) {
@@ -279,16 +807,22 @@ DynamicSegmentTree<
 template <std::integral KeyT, class ValueT, class GetValueT,
           conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
           conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
-          class UpdateOp, class UpdateArgT, class Allocator>
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
   requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
-DynamicSegmentTree<
-    KeyT, ValueT, GetValueT, SegGetComb, SegGetInit, UpdateOp, UpdateArgT,
-    Allocator>::DynamicSegmentTree(const DynamicSegmentTree& other,
-                                   const Allocator& allocator)
+DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit, UpdateOp,
+                   UpdateArgT, Allocator, GetCachePolicy, UpdateCompose,
+                   CoalescePolicy>::
+    DynamicSegmentTree(const DynamicSegmentTree& other,
+                       const Allocator& allocator)
     : nodeAllocator_(allocator),
       rootNode_(other.rootNode_, nodeAllocator_),
       begin_(other.begin_),
       end_(other.end_),
+      lastKey_(other.lastKey_),
       RangeGetInitVariationBase_(other),
       RangeGetCombineVariationBase_(other),
       UpdateVariationBase_(other) {
@@ -298,15 +832,21 @@ DynamicSegmentTree<
 template <std::integral KeyT, class ValueT, class GetValueT,
           conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
           conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
-          class UpdateOp, class UpdateArgT, class Allocator>
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
   requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
-DynamicSegmentTree<
-    KeyT, ValueT, GetValueT, SegGetComb, SegGetInit, UpdateOp, UpdateArgT,
-    Allocator>::DynamicSegmentTree(DynamicSegmentTree&& other) noexcept
+DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit, UpdateOp,
+                   UpdateArgT, Allocator, GetCachePolicy, UpdateCompose,
+                   CoalescePolicy>::
+    DynamicSegmentTree(DynamicSegmentTree&& other) noexcept
     : nodeAllocator_{other.nodeAllocator_},
       rootNode_{std::move(other.rootNode_)},
       begin_{other.begin_},
       end_{other.end_},
+      lastKey_{std::move(other.lastKey_)},
       RangeGetInitVariationBase_(
           static_cast<RangeGetInitVariationBase_&&>(other)),
       RangeGetCombineVariationBase_(
@@ -314,22 +854,29 @@ DynamicSegmentTree<
       UpdateVariationBase_(static_cast<UpdateVariationBase_&&>(other)) {
   other.begin_ = 0;
   other.end_ = 0;
+  other.lastKey_.reset();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 template <std::integral KeyT, class ValueT, class GetValueT,
           conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
           conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
-          class UpdateOp, class UpdateArgT, class Allocator>
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
   requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
-DynamicSegmentTree<
-    KeyT, ValueT, GetValueT, SegGetComb, SegGetInit, UpdateOp, UpdateArgT,
-    Allocator>::DynamicSegmentTree(DynamicSegmentTree&& other,  // NOLINT
-                                   const Allocator& allocator) noexcept
+DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit, UpdateOp,
+                   UpdateArgT, Allocator, GetCachePolicy, UpdateCompose,
+                   CoalescePolicy>::
+    DynamicSegmentTree(DynamicSegmentTree&& other,  // NOLINT
+                       const Allocator& allocator) noexcept
     : nodeAllocator_{allocator},
       rootNode_{std::move(other.rootNode_)},
       begin_{other.begin_},
       end_{other.end_},
+      lastKey_{std::move(other.lastKey_)},
       RangeGetInitVariationBase_(
           static_cast<RangeGetInitVariationBase_&&>(other)),
       RangeGetCombineVariationBase_(
@@ -337,22 +884,26 @@ DynamicSegmentTree<
       UpdateVariationBase_(static_cast<UpdateVariationBase_&&>(other)) {
   other.begin_ = 0;
   other.end_ = 0;
+  other.lastKey_.reset();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 template <std::integral KeyT, class ValueT, class GetValueT,
           conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
           conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
-          class UpdateOp, class UpdateArgT, class Allocator>
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
   requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
 DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit, UpdateOp,
-                   UpdateArgT,
-                   Allocator>::DynamicSegmentTree(KeyT begin, KeyT end,
-                                                  const ValueT& value,
-                                                  const SegGetComb& segGetComb,
-                                                  const SegGetInit& segGetInit,
-                                                  const UpdateOp& updateOp,
-                                                  const Allocator& alloc)
+                   UpdateArgT, Allocator, GetCachePolicy, UpdateCompose,
+                   CoalescePolicy>::
+    DynamicSegmentTree(KeyT begin, KeyT end, const ValueT& value,
+                       const SegGetComb& segGetComb,
+                       const SegGetInit& segGetInit, const UpdateOp& updateOp,
+                       const Allocator& alloc)
     : nodeAllocator_(alloc),
       rootNode_(value),
       begin_(begin),
@@ -366,16 +917,19 @@ DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit, UpdateOp,
 template <std::integral KeyT, class ValueT, class GetValueT,
           conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
           conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
-          class UpdateOp, class UpdateArgT, class Allocator>
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
   requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
 DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit, UpdateOp,
-                   UpdateArgT,
-                   Allocator>::DynamicSegmentTree(KeyT begin, KeyT end,
-                                                  ValueT&& value,
-                                                  const SegGetComb& segGetComb,
-                                                  const SegGetInit& segGetInit,
-                                                  const UpdateOp& updateOp,
-                                                  const Allocator& alloc)
+                   UpdateArgT, Allocator, GetCachePolicy, UpdateCompose,
+                   CoalescePolicy>::
+    DynamicSegmentTree(KeyT begin, KeyT end, ValueT&& value,
+                       const SegGetComb& segGetComb,
+                       const SegGetInit& segGetInit, const UpdateOp& updateOp,
+                       const Allocator& alloc)
     : nodeAllocator_(alloc),
       rootNode_(std::move(value)),
       begin_(begin),
@@ -389,11 +943,88 @@ DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit, UpdateOp,
 template <std::integral KeyT, class ValueT, class GetValueT,
           conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
           conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
-          class UpdateOp, class UpdateArgT, class Allocator>
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit, UpdateOp,
+                   UpdateArgT, Allocator, GetCachePolicy, UpdateCompose,
+                   CoalescePolicy>::
+    DynamicSegmentTree(FullKeyRange, const ValueT& value,
+                       const SegGetComb& segGetComb,
+                       const SegGetInit& segGetInit, const UpdateOp& updateOp,
+                       const Allocator& alloc)
+    : DynamicSegmentTree(std::numeric_limits<KeyT>::min(),
+                         std::numeric_limits<KeyT>::max(), value, segGetComb,
+                         segGetInit, updateOp, alloc) {
+  lastKey_.emplace(value);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit, UpdateOp,
+                   UpdateArgT, Allocator, GetCachePolicy, UpdateCompose,
+                   CoalescePolicy>::
+    DynamicSegmentTree(FullKeyRange, ValueT&& value,
+                       const SegGetComb& segGetComb,
+                       const SegGetInit& segGetInit, const UpdateOp& updateOp,
+                       const Allocator& alloc)
+    : DynamicSegmentTree(std::numeric_limits<KeyT>::min(),
+                         std::numeric_limits<KeyT>::max(), value, segGetComb,
+                         segGetInit, updateOp, alloc) {
+  lastKey_.emplace(std::move(value));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+template <conc::LeafRunRange<KeyT, ValueT> Runs>
+DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit, UpdateOp,
+                   UpdateArgT, Allocator, GetCachePolicy, UpdateCompose,
+                   CoalescePolicy>::
+    DynamicSegmentTree(KeyT begin, KeyT end, const Runs& runs,
+                       const ValueT& value, const SegGetComb& segGetComb,
+                       const SegGetInit& segGetInit, const UpdateOp& updateOp,
+                       const Allocator& alloc)
+    : DynamicSegmentTree(begin, end, value, segGetComb, segGetInit, updateOp,
+                         alloc) {
+  auto runIt = std::ranges::begin(runs);
+  if (begin < end) {
+    buildFromRuns_(begin_, end_, &rootNode_, runIt, std::ranges::end(runs));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
   requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
-auto DynamicSegmentTree<
-    KeyT, ValueT, GetValueT, SegGetComb, SegGetInit, UpdateOp, UpdateArgT,
-    Allocator>::operator=(const DynamicSegmentTree& other) -> This_& {
+auto DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                        UpdateOp, UpdateArgT, Allocator, GetCachePolicy,
+                        UpdateCompose, CoalescePolicy>::
+    operator=(const DynamicSegmentTree& other) -> This_& {
   if (this == &other) {
     return *this;
   }
@@ -406,6 +1037,7 @@ auto DynamicSegmentTree<
   nodeAllocator_ = other.nodeAllocator_;
   begin_ = other.begin_;
   end_ = other.end_;
+  lastKey_ = other.lastKey_;
   rootNode_.assign(other.rootNode_, nodeAllocator_);
   return *this;
 }
@@ -414,11 +1046,16 @@ auto DynamicSegmentTree<
 template <std::integral KeyT, class ValueT, class GetValueT,
           conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
           conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
-          class UpdateOp, class UpdateArgT, class Allocator>
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
   requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
-auto DynamicSegmentTree<
-    KeyT, ValueT, GetValueT, SegGetComb, SegGetInit, UpdateOp, UpdateArgT,
-    Allocator>::operator=(DynamicSegmentTree&& other) noexcept -> This_& {
+auto DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                        UpdateOp, UpdateArgT, Allocator, GetCachePolicy,
+                        UpdateCompose, CoalescePolicy>::
+    operator=(DynamicSegmentTree&& other) noexcept -> This_& {
   if (this == &other) {
     return *this;
   }
@@ -431,6 +1068,7 @@ auto DynamicSegmentTree<
   std::swap(rootNode_, other.rootNode_);
   std::swap(begin_, other.begin_);
   std::swap(end_, other.end_);
+  std::swap(lastKey_, other.lastKey_);
   return *this;
 }
 
@@ -453,12 +1091,20 @@ auto DynamicSegmentTree<
 template <std::integral KeyT, class ValueT, class GetValueT,
           conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
           conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
-          class UpdateOp, class UpdateArgT, class Allocator>
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
   requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
 void DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
-                        UpdateOp, UpdateArgT,
-                        Allocator>::set(KeyT begin, KeyT end,
-                                        const ValueT& toSet) {
+                        UpdateOp, UpdateArgT, Allocator, GetCachePolicy,
+                        UpdateCompose, CoalescePolicy>::
+    set(KeyT begin, KeyT end, const ValueT& toSet) {
+  if (reachesLastKey_(end)) {
+    *lastKey_ = toSet;
+    end = end_;
+  }
   if (begin < end) {
     setImpl_(begin, end, begin_, end_, &rootNode_, toSet);
   }
@@ -468,12 +1114,24 @@ void DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
 template <std::integral KeyT, class ValueT, class GetValueT,
           conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
           conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
-          class UpdateOp, class UpdateArgT, class Allocator>
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
   requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
 void DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
-                        UpdateOp, UpdateArgT, Allocator>::set(KeyT begin,
-                                                              KeyT end,
-                                                              ValueT&& toSet) {
+                        UpdateOp, UpdateArgT, Allocator, GetCachePolicy,
+                        UpdateCompose, CoalescePolicy>::
+    set(KeyT begin, KeyT end, ValueT&& toSet) {
+  if (reachesLastKey_(end)) {
+    end = end_;
+    if (begin >= end) {
+      *lastKey_ = std::move(toSet);
+      return;
+    }
+    *lastKey_ = toSet;
+  }
   if (begin < end) {
     setImpl_(begin, end, begin_, end_, &rootNode_, std::move(toSet));
   }
@@ -483,110 +1141,194 @@ void DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
 template <std::integral KeyT, class ValueT, class GetValueT,
           conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
           conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
-          class UpdateOp, class UpdateArgT, class Allocator>
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
   requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
-const ValueT&
-DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit, UpdateOp,
-                   UpdateArgT, Allocator>::get(KeyT key) const {
-  if (key >= end_ || key < begin_) {
-    std::stringstream messageStream;
-    messageStream << "Get operation for " << key << ", which is out of range.";
-    throw std::out_of_range(messageStream.str());
-  }
-  return getImpl_(key, begin_, end_, &rootNode_);
+GetValueT DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                             UpdateOp, UpdateArgT, Allocator, GetCachePolicy,
+                             UpdateCompose, CoalescePolicy>::
+    exchange(KeyT begin, KeyT end, const ValueT& toSet)
+  requires conc::GetCombiner<SegGetComb, GetValueT, KeyT> &&
+           conc::GetInitializer<SegGetInit, ValueT, KeyT, GetValueT>
+{
+  return modifyAndGet_(
+      begin, end, [&](Node_* node, KeyT nodeBegin, KeyT nodeEnd) {
+        PendingPath_ pending;
+        GetValueT old = rangeGetImpl_(nodeBegin, nodeEnd, nodeBegin, nodeEnd,
+                                      node, pending);
+        node->setValue(toSet, nodeAllocator_);
+        return old;
+      },
+      [&] {
+        GetValueT old = lastKeyGet_();
+        *lastKey_ = toSet;
+        return old;
+      });
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 template <std::integral KeyT, class ValueT, class GetValueT,
           conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
           conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
-          class UpdateOp, class UpdateArgT, class Allocator>
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
   requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
-GetValueT
-DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit, UpdateOp,
-                   UpdateArgT, Allocator>::rangeGet(KeyT begin, KeyT end) const
-  requires conc::GetCombiner<SegGetComb, GetValueT, KeyT> &&
-           conc::GetInitializer<SegGetInit, ValueT, KeyT, GetValueT>
-{
-  return rangeGetImpl_(begin, end, begin_, end_, &rootNode_);
+void DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                        UpdateOp, UpdateArgT, Allocator, GetCachePolicy,
+                        UpdateCompose, CoalescePolicy>::
+    setBatch(std::span<const std::tuple<KeyT, KeyT, ValueT>> toSet) {
+  // Indices of operations of a visited node are kept in order on top of the
+  // stack. Children lists are pushed over them during the descent.
+  auto opIndices = std::vector<std::size_t>();
+  opIndices.reserve(toSet.size() * 2);
+  for (std::size_t i = 0; i < toSet.size(); ++i) {
+    const auto& [begin, end, value] = toSet[i];
+    if (reachesLastKey_(end)) {
+      *lastKey_ = value;
+    }
+    if (begin < rootEnd_(end)) {
+      opIndices.push_back(i);
+    }
+  }
+  if (!opIndices.empty()) {
+    setBatchImpl_(toSet, opIndices, 0, begin_, end_, &rootNode_);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 template <std::integral KeyT, class ValueT, class GetValueT,
           conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
           conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
-          class UpdateOp, class UpdateArgT, class Allocator>
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
   requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
-DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit, UpdateOp,
-                   UpdateArgT, Allocator>::~DynamicSegmentTree() {
-  if (!rootNode_.isLeaf()) {
-    rootNode_.clearChildren(nodeAllocator_);
+auto DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                        UpdateOp, UpdateArgT, Allocator, GetCachePolicy,
+                        UpdateCompose, CoalescePolicy>::get(KeyT key) const
+    -> GetResult_ {
+  if (key >= end_ || key < begin_) {
+    if (lastKey_.has_value() && key == end_) {
+      return *lastKey_;
+    }
+    throwGetOutOfRange_(key);
   }
+  PendingPath_ pending;
+  const Node_* currNode = &rootNode_;
+  KeyT currBegin = begin_;
+  KeyT currEnd = end_;
+  while (!currNode->isLeaf()) {
+    pending.push(*currNode);
+    if (const auto mid = impl::midpoint(currBegin, currEnd); key >= mid) {
+      currBegin = mid;
+      currNode = currNode->getRight();
+    } else {
+      currEnd = mid;
+      currNode = currNode->getLeft();
+    }
+  }
+  return UpdateVariationBase_::applyPending_(pending, currNode->getValue());
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 template <std::integral KeyT, class ValueT, class GetValueT,
           conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
           conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
-          class UpdateOp, class UpdateArgT, class Allocator>
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
   requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
-template <class ValueT1>
-  requires std::is_same_v<std::remove_cvref_t<ValueT1>, ValueT>
-void DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
-                        UpdateOp, UpdateArgT,
-                        Allocator>::setImpl_(KeyT begin, KeyT end,
-                                             KeyT currBegin, KeyT currEnd,
-                                             Node_* currNode,
-                                             ValueT1&& toUpdate) {
-  assert(currBegin < end && "currBegin must be checked before call.");
-  assert(currEnd > begin && "currEnd must be checked before call.");
-  assert(begin < end && "Function must not be called on empty range");
-  if (end >= currEnd && begin <= currBegin) {
-    currNode->setValue(std::forward<ValueT1>(toUpdate), nodeAllocator_);
-    return;
+auto DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                        UpdateOp, UpdateArgT, Allocator, GetCachePolicy,
+                        UpdateCompose, CoalescePolicy>::
+    getByOffsetBits_(std::make_unsigned_t<KeyT> offset,
+                     std::make_unsigned_t<KeyT> half) const -> GetResult_ {
+  PendingPath_ pending;
+  const Node_* currNode = &rootNode_;
+  for (auto bit = half; !currNode->isLeaf(); bit >>= 1) {
+    assert(bit != 0 && "Working area length must be a power of two.");
+    pending.push(*currNode);
+    currNode =
+        (offset & bit) != 0 ? currNode->getRight() : currNode->getLeft();
   }
-  if (currNode->isLeaf()) {
-    currNode->initChildren(nodeAllocator_);
+  return UpdateVariationBase_::applyPending_(pending, currNode->getValue());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+auto DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                        UpdateOp, UpdateArgT, Allocator, GetCachePolicy,
+                        UpdateCompose, CoalescePolicy>::LeafIterator::
+operator++() -> LeafIterator& {
+  assert((leaf_ != nullptr || atLastKey_) &&
+         "Iterator must not be incremented past the end.");
+  if (atLastKey_) {
+    atLastKey_ = false;
+    return *this;
   }
-  UpdateVariationBase_::optionalSiftNodeUpdate_(currNode, nodeAllocator_);
-  const auto mid = (currBegin + currEnd) / 2;
-  if (mid >= end) {
-    // Only move to left as right is out of range.
-    setImpl_(begin, end, currBegin, mid, currNode->getLeft(),
-             std::forward<ValueT1>(toUpdate));
-    return;
+  if (leafEnd_ == tree_->end_) {
+    leaf_ = nullptr;
+    if (tree_->lastKey_.has_value()) {
+      atLastKey_ = true;
+      leafBegin_ = leafEnd_;
+      leafEnd_ = std::numeric_limits<KeyT>::min();
+    }
+    return *this;
   }
-  if (mid <= begin) {
-    // Only move to right as left is out of range.
-    setImpl_(begin, end, mid, currEnd, currNode->getRight(),
-             std::forward<ValueT1>(toUpdate));
-    return;
+  // Climb up to the first ancestor, where the current leaf is in the left
+  // subtree, and descend to the leftmost leaf of its right subtree.
+  while (leafEnd_ >= path_[depth_ - 1].end) {
+    pending_.pop(*path_[--depth_].node);
   }
-  // Copy to left and move to right
-  setImpl_(begin, end, currBegin, mid, currNode->getLeft(), toUpdate);
-  setImpl_(begin, end, mid, currEnd, currNode->getRight(),
-           std::forward<ValueT1>(toUpdate));
+  const PathFrame_& frame = path_[depth_ - 1];
+  descend_(frame.node->getRight(), leafEnd_, frame.end);
+  return *this;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 template <std::integral KeyT, class ValueT, class GetValueT,
           conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
           conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
-          class UpdateOp, class UpdateArgT, class Allocator>
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
   requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
-const ValueT&
-DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit, UpdateOp,
-                   UpdateArgT, Allocator>::getImpl_(KeyT key, KeyT currBegin,
-                                                    KeyT currEnd,
-                                                    Node_* currNode) const {
-  if (currNode->isLeaf()) {
-    return currNode->getValue();
+void DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                        UpdateOp, UpdateArgT, Allocator, GetCachePolicy,
+                        UpdateCompose, CoalescePolicy>::LeafIterator::
+    descend_(const Node_* node, KeyT nodeBegin, KeyT nodeEnd) {
+  while (!node->isLeaf()) {
+    assert(depth_ < kMaxDepth_ && "Path is too long.");
+    pending_.push(*node);
+    path_[depth_++] = PathFrame_{node, nodeBegin, nodeEnd};
+    nodeEnd = impl::midpoint(nodeBegin, nodeEnd);
+    node = node->getLeft();
   }
-  UpdateVariationBase_::optionalSiftNodeUpdate_(currNode, nodeAllocator_);
-  if (const auto mid = (currBegin + currEnd) / 2; key >= mid) {
-    return getImpl_(key, mid, currEnd, currNode->getRight());
-  } else {
-    return getImpl_(key, currBegin, mid, currNode->getLeft());
+  leaf_ = node;
+  leafBegin_ = nodeBegin;
+  leafEnd_ = nodeEnd;
+  if constexpr (!std::is_same_v<UpdateOp, NoUpdateOp>) {
+    value_.emplace(tree_->applyPending_(pending_, node->getValue()));
   }
 }
 
@@ -594,45 +1336,1166 @@ DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit, UpdateOp,
 template <std::integral KeyT, class ValueT, class GetValueT,
           conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
           conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
-          class UpdateOp, class UpdateArgT, class Allocator>
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
   requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
-GetValueT DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
-                             UpdateOp, UpdateArgT,
-                             Allocator>::rangeGetImpl_(KeyT begin, KeyT end,
-                                                       KeyT currBegin,
-                                                       KeyT currEnd,
-                                                       Node_* currNode) const {
-  if (begin > currEnd || currBegin > end) {
-    assert(false &&
-           "_rangeGetImpl must not be called out of initial get range.");
-    return ValueT{};
+template <std::output_iterator<const ValueT&> OutputIt>
+OutputIt
+DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit, UpdateOp,
+                   UpdateArgT, Allocator, GetCachePolicy, UpdateCompose,
+                   CoalescePolicy>::getMany(std::span<const KeyT> keys,
+                                            OutputIt out) const {
+  // Internal nodes from the root down to the last visited leaf.
+  std::array<PathFrame_, kMaxDepth_> path;
+  std::size_t depth = 0;
+  PendingPath_ pending;
+  for (const KeyT key : keys) {
+    if (key >= end_ || key < begin_) {
+      if (!lastKey_.has_value() || key != end_) {
+        throwGetOutOfRange_(key);
+      }
+      *out = *lastKey_;
+      ++out;
+      continue;
+    }
+    // Climb up to the deepest common ancestor.
+    while (depth > 0 &&
+           (key < path[depth - 1].begin || key >= path[depth - 1].end)) {
+      pending.pop(*path[--depth].node);
+    }
+    const Node_* currNode = &rootNode_;
+    KeyT currBegin = begin_;
+    KeyT currEnd = end_;
+    if (depth > 0) {
+      const PathFrame_& frame = path[depth - 1];
+      if (const auto mid = impl::midpoint(frame.begin, frame.end); key >= mid) {
+        currNode = frame.node->getRight();
+        currBegin = mid;
+        currEnd = frame.end;
+      } else {
+        currNode = frame.node->getLeft();
+        currBegin = frame.begin;
+        currEnd = mid;
+      }
+    }
+    while (!currNode->isLeaf()) {
+      assert(depth < kMaxDepth_ && "Path is too long.");
+      pending.push(*currNode);
+      path[depth++] = PathFrame_{currNode, currBegin, currEnd};
+      if (const auto mid = impl::midpoint(currBegin, currEnd); key >= mid) {
+        currBegin = mid;
+        currNode = currNode->getRight();
+      } else {
+        currEnd = mid;
+        currNode = currNode->getLeft();
+      }
+    }
+    *out = UpdateVariationBase_::applyPending_(pending, currNode->getValue());
+    ++out;
   }
-  if (end >= currEnd && begin <= currBegin && currNode->isLeaf()) {
-    return RangeGetInitVariationBase_::initGet_(currBegin, currEnd,
-                                                currNode->getValue());
+  return out;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+GetValueT
+DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit, UpdateOp,
+                   UpdateArgT, Allocator, GetCachePolicy, UpdateCompose,
+                   CoalescePolicy>::rangeGet(KeyT begin, KeyT end) const
+  requires conc::GetCombiner<SegGetComb, GetValueT, KeyT> &&
+           conc::GetInitializer<SegGetInit, ValueT, KeyT, GetValueT>
+{
+  PendingPath_ pending;
+  if (reachesLastKey_(end)) {
+    if (begin >= end_) {
+      return lastKeyGet_();
+    }
+    return RangeGetCombineVariationBase_::combineGet_(
+        rangeGetImpl_(begin, end_, begin_, end_, &rootNode_, pending),
+        lastKeyGet_(), begin, end_, end);
+  }
+  return rangeGetImpl_(begin, end, begin_, end_, &rootNode_, pending);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+void DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                        UpdateOp, UpdateArgT, Allocator, GetCachePolicy,
+                        UpdateCompose, CoalescePolicy>::
+    rangeGetBatch(std::span<const std::pair<KeyT, KeyT>> ranges,
+                  std::span<GetValueT> out) const
+  requires conc::GetCombiner<SegGetComb, GetValueT, KeyT> &&
+           conc::GetInitializer<SegGetInit, ValueT, KeyT, GetValueT>
+{
+  if (out.size() < ranges.size()) {
+    throw std::invalid_argument("Not enough space for results.");
+  }
+  // Same stack of indices as in setBatch.
+  auto rangeIndices = std::vector<std::size_t>();
+  rangeIndices.reserve(ranges.size() * 2);
+  for (std::size_t i = 0; i < ranges.size(); ++i) {
+    if (const auto& [begin, end] = ranges[i];
+        std::max(begin, begin_) < std::min(rootEnd_(end), end_)) {
+      rangeIndices.push_back(i);
+    } else {
+      out[i] = rangeGet(begin, end);
+    }
+  }
+  if (!rangeIndices.empty()) {
+    PendingPath_ pending;
+    rangeGetBatchImpl_(ranges, out, rangeIndices, 0, begin_, end_, &rootNode_,
+                       pending);
+  }
+  // The maximal key of a tree over all keys is the last part of its ranges.
+  for (const std::size_t i : rangeIndices) {
+    if (const auto& [begin, end] = ranges[i]; reachesLastKey_(end)) {
+      out[i] = RangeGetCombineVariationBase_::combineGet_(
+          out[i], lastKeyGet_(), std::max(begin, begin_), end_, end);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+template <std::predicate<const GetValueT&> Pred>
+std::optional<KeyT>
+DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit, UpdateOp,
+                   UpdateArgT, Allocator, GetCachePolicy, UpdateCompose,
+                   CoalescePolicy>::findFirst(KeyT begin, KeyT end,
+                                              Pred pred) const
+  requires conc::GetCombiner<SegGetComb, GetValueT, KeyT> &&
+           conc::GetInitializer<SegGetInit, ValueT, KeyT, GetValueT>
+{
+  const bool withLastKey = reachesLastKey_(end);
+  begin = std::max(begin, begin_);
+  end = std::min(rootEnd_(end), end_);
+  // Result on the checked part of a range.
+  auto acc = std::optional<GetValueT>();
+  if (begin < end) {
+    PendingPath_ pending;
+    if (auto key = findFirstImpl_(begin, end, begin_, end_, &rootNode_, pred,
+                                  acc, pending)) {
+      return key;
+    }
+  }
+  if (withLastKey) {
+    const GetValueT whole =
+        acc.has_value() ? RangeGetCombineVariationBase_::combineGet_(
+                              *acc, lastKeyGet_(), begin, end_,
+                              std::numeric_limits<KeyT>::min())
+                        : lastKeyGet_();
+    if (pred(whole)) {
+      return end_;
+    }
+  }
+  return std::nullopt;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+template <std::totally_ordered_with<GetValueT> TargetT>
+std::optional<KeyT>
+DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit, UpdateOp,
+                   UpdateArgT, Allocator, GetCachePolicy, UpdateCompose,
+                   CoalescePolicy>::lowerBoundPrefix(const TargetT& target)
+    const
+  requires conc::GetCombiner<SegGetComb, GetValueT, KeyT> &&
+           conc::GetInitializer<SegGetInit, ValueT, KeyT, GetValueT>
+{
+  return findFirst(begin_, areaEnd_(), [&target](const GetValueT& prefix) {
+    return !(prefix < target);
+  });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+template <std::totally_ordered_with<GetValueT> CountT>
+std::optional<KeyT>
+DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit, UpdateOp,
+                   UpdateArgT, Allocator, GetCachePolicy, UpdateCompose,
+                   CoalescePolicy>::kth(const CountT& k) const
+  requires conc::GetCombiner<SegGetComb, GetValueT, KeyT> &&
+           conc::GetInitializer<SegGetInit, ValueT, KeyT, GetValueT>
+{
+  return findFirst(begin_, areaEnd_(),
+                   [&k](const GetValueT& prefix) { return k < prefix; });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+std::pair<KeyT, ValueT>
+DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit, UpdateOp,
+                   UpdateArgT, Allocator, GetCachePolicy, UpdateCompose,
+                   CoalescePolicy>::rangeArgMin(KeyT begin, KeyT end) const
+  requires std::totally_ordered<ValueT>
+{
+  return rangeArgExtreme_<std::less<>>(begin, end);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+std::pair<KeyT, ValueT>
+DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit, UpdateOp,
+                   UpdateArgT, Allocator, GetCachePolicy, UpdateCompose,
+                   CoalescePolicy>::rangeArgMax(KeyT begin, KeyT end) const
+  requires std::totally_ordered<ValueT>
+{
+  return rangeArgExtreme_<std::greater<>>(begin, end);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+void DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                        UpdateOp, UpdateArgT, Allocator, GetCachePolicy,
+                        UpdateCompose,
+                        CoalescePolicy>::serialize(std::ostream& out) const
+  requires conc::Serializable<KeyT> && conc::Serializable<ValueT> &&
+           conc::OptSerializable<UpdateArgT>
+{
+  auto internal = std::vector<bool>();
+  auto pending = std::vector<bool>();
+  collectShape_(&rootNode_, internal, pending);
+  out.write(impl::kSerializationMagic.data(), impl::kSerializationMagic.size());
+  Serializer<KeyT>::write(out, begin_);
+  Serializer<KeyT>::write(out, end_);
+  Serializer<std::uint64_t>::write(out, internal.size());
+  impl::writeBits(out, internal);
+  impl::writeBits(out, pending);
+  writeNodes_(&rootNode_, out);
+  Serializer<std::uint8_t>::write(out, lastKey_.has_value() ? 1 : 0);
+  if (lastKey_.has_value()) {
+    Serializer<ValueT>::write(out, *lastKey_);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+auto DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                        UpdateOp, UpdateArgT, Allocator, GetCachePolicy,
+                        UpdateCompose, CoalescePolicy>::
+    deserialize(std::istream& in, const SegGetComb& segGetComb,
+                const SegGetInit& segGetInit, const UpdateOp& updateOp,
+                const Allocator& alloc) -> DynamicSegmentTree
+  requires conc::Serializable<KeyT> && conc::Serializable<ValueT> &&
+           conc::OptSerializable<UpdateArgT>
+{
+  auto magic = decltype(impl::kSerializationMagic)();
+  in.read(magic.data(), magic.size());
+  impl::checkReadStream(in);
+  if (magic != impl::kSerializationMagic) {
+    throw std::runtime_error("Not a serialized dynamic segment tree.");
+  }
+  const KeyT begin = Serializer<KeyT>::read(in);
+  const KeyT end = Serializer<KeyT>::read(in);
+  const auto nodesCount = Serializer<std::uint64_t>::read(in);
+  impl::checkReadStream(in);
+  // A tree of n keys has at most 2n - 1 nodes.
+  if (nodesCount == 0 ||
+      (nodesCount > 1 && nodesCount / 2 >= impl::keyDistance(begin, end))) {
+    throw std::runtime_error("Serialized tree shape is corrupted.");
+  }
+  const auto internal = impl::readBits(in, nodesCount);
+  const auto pending = impl::readBits(in, nodesCount);
+  // Values go in postorder, so the first one is the leftmost leaf value.
+  auto tree =
+      DynamicSegmentTree(begin, end, Serializer<ValueT>::read(in), segGetComb,
+                         segGetInit, updateOp, alloc);
+  impl::checkReadStream(in);
+  auto nodeIdx = std::size_t{0};
+  tree.readNodes_(in, internal, pending, nodeIdx, begin, end, &tree.rootNode_,
+                  true);
+  if (nodeIdx != nodesCount) {
+    throw std::runtime_error("Serialized tree shape is corrupted.");
+  }
+  const auto hasLastKey = Serializer<std::uint8_t>::read(in);
+  impl::checkReadStream(in);
+  if (hasLastKey > 1 ||
+      (hasLastKey == 1 && (begin != std::numeric_limits<KeyT>::min() ||
+                           end != std::numeric_limits<KeyT>::max()))) {
+    throw std::runtime_error("Serialized tree shape is corrupted.");
+  }
+  if (hasLastKey == 1) {
+    tree.lastKey_.emplace(Serializer<ValueT>::read(in));
+    impl::checkReadStream(in);
+  }
+  return tree;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit, UpdateOp,
+                   UpdateArgT, Allocator, GetCachePolicy, UpdateCompose,
+                   CoalescePolicy>::~DynamicSegmentTree() {
+  if (rootNode_.isLeaf()) {
+    return;
+  }
+  if constexpr (conc::BulkReleaseAllocator<NodeAlloc_> &&
+                kTriviallyDestructibleNodes_) {
+    if (nodeAllocator_.clearIfExclusive()) {
+      rootNode_.abandonChildren();
+      return;
+    }
+  }
+  rootNode_.clearChildren(nodeAllocator_);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+template <class ValueT1>
+  requires std::is_same_v<std::remove_cvref_t<ValueT1>, ValueT>
+void DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                        UpdateOp, UpdateArgT, Allocator, GetCachePolicy,
+                        UpdateCompose, CoalescePolicy>::
+    setImpl_(KeyT begin, KeyT end, KeyT currBegin, KeyT currEnd,
+             Node_* currNode, ValueT1&& toUpdate) {
+  assert(currBegin < end && "currBegin must be checked before call.");
+  assert(currEnd > begin && "currEnd must be checked before call.");
+  assert(begin < end && "Function must not be called on empty range");
+  // Set range touches at most two paths: from a node, where it splits, to
+  // its beginning and to its ending. Children of these paths are either
+  // untouched or fully covered.
+  std::array<SetFrame_, 2 * kMaxDepth_> changed;  // NOLINT
+  std::size_t changedSize = 0;
+  const auto expand = [&](Node_* node, KeyT nodeBegin, KeyT nodeEnd) {
+    if (node->isLeaf()) {
+      node->initChildren(nodeAllocator_);
+    }
+    UpdateVariationBase_::optionalSiftNodeUpdate_(node, nodeBegin, nodeEnd,
+                                                  nodeAllocator_);
+    assert(changedSize < changed.size() && "Path is too long.");
+    changed[changedSize++] = SetFrame_{node, nodeBegin, nodeEnd};
+    return impl::midpoint(nodeBegin, nodeEnd);
+  };
+
+  auto mid = currBegin;
+  while (end < currEnd || begin > currBegin) {
+    mid = expand(currNode, currBegin, currEnd);
+    if (end <= mid) {
+      currNode = currNode->getLeft();
+      currEnd = mid;
+    } else if (begin >= mid) {
+      currNode = currNode->getRight();
+      currBegin = mid;
+    } else {
+      break;
+    }
+  }
+
+  if (end >= currEnd && begin <= currBegin) {
+    currNode->setValue(std::forward<ValueT1>(toUpdate), nodeAllocator_);
+  } else {
+    // Path to the beginning. Right children on it are covered.
+    Node_* leftNode = currNode->getLeft();
+    KeyT leftBegin = currBegin;
+    KeyT leftEnd = mid;
+    while (begin > leftBegin) {
+      const auto leftMid = expand(leftNode, leftBegin, leftEnd);
+      if (begin >= leftMid) {
+        leftNode = leftNode->getRight();
+        leftBegin = leftMid;
+      } else {
+        leftNode->getRight()->setValue(std::as_const(toUpdate),
+                                       nodeAllocator_);
+        leftNode = leftNode->getLeft();
+        leftEnd = leftMid;
+      }
+    }
+    leftNode->setValue(std::as_const(toUpdate), nodeAllocator_);
+
+    // Path to the ending. Left children on it are covered.
+    Node_* rightNode = currNode->getRight();
+    KeyT rightBegin = mid;
+    KeyT rightEnd = currEnd;
+    while (end < rightEnd) {
+      const auto rightMid = expand(rightNode, rightBegin, rightEnd);
+      if (end <= rightMid) {
+        rightNode = rightNode->getLeft();
+        rightEnd = rightMid;
+      } else {
+        rightNode->getLeft()->setValue(std::as_const(toUpdate),
+                                       nodeAllocator_);
+        rightNode = rightNode->getRight();
+        rightBegin = rightMid;
+      }
+    }
+    rightNode->setValue(std::forward<ValueT1>(toUpdate), nodeAllocator_);
+  }
+
+  // Children are always processed before their parents.
+  while (changedSize != 0) {
+    const SetFrame_& frame = changed[--changedSize];
+    afterChildrenChanged_(frame.node, frame.begin,
+                          impl::midpoint(frame.begin, frame.end), frame.end);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+template <class RunIt, class RunSentinel>
+void DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                        UpdateOp, UpdateArgT, Allocator, GetCachePolicy,
+                        UpdateCompose, CoalescePolicy>::
+    buildFromRuns_(KeyT currBegin, KeyT currEnd, Node_* currNode,
+                   RunIt& runIt, const RunSentinel& runsEnd) {
+  // Skip runs, which end before the node, and empty ones.
+  while (runIt != runsEnd && (std::get<1>(*runIt) <= currBegin ||
+                              std::get<0>(*runIt) >= std::get<1>(*runIt))) {
+    ++runIt;
+  }
+  if (runIt == runsEnd || std::get<0>(*runIt) >= currEnd) {
+    return;  // Node is out of runs and keeps the filling value.
+  }
+  if (std::get<0>(*runIt) <= currBegin && std::get<1>(*runIt) >= currEnd) {
+    currNode->setValue(static_cast<const ValueT&>(std::get<2>(*runIt)),
+                       nodeAllocator_);
+    return;
+  }
+  currNode->initChildren(nodeAllocator_);
+  const auto mid = impl::midpoint(currBegin, currEnd);
+  buildFromRuns_(currBegin, mid, currNode->getLeft(), runIt, runsEnd);
+  buildFromRuns_(mid, currEnd, currNode->getRight(), runIt, runsEnd);
+  afterChildrenChanged_(currNode, currBegin, mid, currEnd);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+void DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                        UpdateOp, UpdateArgT, Allocator, GetCachePolicy,
+                        UpdateCompose, CoalescePolicy>::
+    setBatchImpl_(std::span<const std::tuple<KeyT, KeyT, ValueT>> toSet,
+                  std::vector<std::size_t>& opIndices, std::size_t first,
+                  KeyT currBegin, KeyT currEnd, Node_* currNode) {
+  assert(first < opIndices.size() && "Operations list must not be empty.");
+  // Operations before the last one covering the whole node are overwritten.
+  for (std::size_t i = opIndices.size(); i > first; --i) {
+    const auto& [begin, end, value] = toSet[opIndices[i - 1]];
+    if (rootEnd_(end) >= currEnd && begin <= currBegin) {
+      currNode->setValue(value, nodeAllocator_);
+      first = i;
+      break;
+    }
+  }
+  const std::size_t last = opIndices.size();
+  if (first == last) {
+    return;
   }
   if (currNode->isLeaf()) {
     currNode->initChildren(nodeAllocator_);
   }
+  UpdateVariationBase_::optionalSiftNodeUpdate_(currNode, currBegin, currEnd,
+                                                nodeAllocator_);
+  const auto mid = impl::midpoint(currBegin, currEnd);
+  for (std::size_t i = first; i < last; ++i) {
+    if (std::get<0>(toSet[opIndices[i]]) < mid) {
+      opIndices.push_back(opIndices[i]);
+    }
+  }
+  if (opIndices.size() > last) {
+    setBatchImpl_(toSet, opIndices, last, currBegin, mid,
+                  currNode->getLeft());
+    opIndices.resize(last);
+  }
+  for (std::size_t i = first; i < last; ++i) {
+    if (rootEnd_(std::get<1>(toSet[opIndices[i]])) > mid) {
+      opIndices.push_back(opIndices[i]);
+    }
+  }
+  if (opIndices.size() > last) {
+    setBatchImpl_(toSet, opIndices, last, mid, currEnd,
+                  currNode->getRight());
+    opIndices.resize(last);
+  }
+  afterChildrenChanged_(currNode, currBegin, mid, currEnd);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+GetValueT DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                             UpdateOp, UpdateArgT, Allocator, GetCachePolicy,
+                             UpdateCompose, CoalescePolicy>::
+    rangeGetImpl_(KeyT begin, KeyT end, KeyT currBegin, KeyT currEnd,
+                  const Node_* currNode, PendingPath_& pending) const {
+  if (begin > currEnd || currBegin > end) {
+    assert(false &&
+           "_rangeGetImpl must not be called out of initial get range.");
+    return ValueT{};
+  }
+  if (currNode->isLeaf()) {
+    // Partially covered leaf is not split, its part is initialized directly.
+    return RangeGetInitVariationBase_::initGet_(
+        std::max(currBegin, begin), std::min(currEnd, end),
+        UpdateVariationBase_::applyPending_(pending, currNode->getValue()));
+  }
+  if constexpr (kCacheRangeGet_) {
+    if (end >= currEnd && begin <= currBegin) {
+      // Cached result does not include updates delayed in ancestors.
+      return UpdateVariationBase_::applyPendingToGet_(
+          pending, currNode->getCachedGet(), currBegin, currEnd);
+    }
+  }
+
+  pending.push(*currNode);
+  const auto mid = impl::midpoint(currBegin, currEnd);
+
+  GetValueT ret = [&]() -> GetValueT {
+    if (begin >= mid) {  // only right
+      return rangeGetImpl_(begin, end, mid, currEnd, currNode->getRight(),
+                           pending);
+    }
+    if (end <= mid) {  // only left
+      return rangeGetImpl_(begin, end, currBegin, mid, currNode->getLeft(),
+                           pending);
+    }
+    const GetValueT rVal = rangeGetImpl_(begin, end, mid, currEnd,
+                                         currNode->getRight(), pending);
+    const GetValueT lVal = rangeGetImpl_(begin, end, currBegin, mid,
+                                         currNode->getLeft(), pending);
+    return RangeGetCombineVariationBase_::combineGet_(
+        lVal, rVal, std::max(currBegin, begin), mid, std::min(currEnd, end));
+  }();
+
+  pending.pop(*currNode);
+  return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+void DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                        UpdateOp, UpdateArgT, Allocator, GetCachePolicy,
+                        UpdateCompose, CoalescePolicy>::
+    rangeGetBatchImpl_(std::span<const std::pair<KeyT, KeyT>> ranges,
+                       std::span<GetValueT> out,
+                       std::vector<std::size_t>& rangeIndices,
+                       std::size_t first, KeyT currBegin, KeyT currEnd,
+                       const Node_* currNode, PendingPath_& pending) const {
+  // Parts of a range come from left to right, the first one starts with its
+  // part in the working area.
+  const auto addPart = [&](std::size_t rangeIdx, KeyT partBegin, KeyT partEnd,
+                           const GetValueT& part) {
+    if (const KeyT begin = std::max(ranges[rangeIdx].first, begin_);
+        partBegin == begin) {
+      out[rangeIdx] = part;
+    } else {
+      out[rangeIdx] = RangeGetCombineVariationBase_::combineGet_(
+          out[rangeIdx], part, begin, partBegin, partEnd);
+    }
+  };
+  const std::size_t last = rangeIndices.size();
+  if (currNode->isLeaf()) {
+    const auto& value =
+        UpdateVariationBase_::applyPending_(pending, currNode->getValue());
+    for (std::size_t i = first; i < last; ++i) {
+      const KeyT partBegin = std::max(currBegin, ranges[rangeIndices[i]].first);
+      const KeyT partEnd =
+          std::min(currEnd, rootEnd_(ranges[rangeIndices[i]].second));
+      addPart(rangeIndices[i], partBegin, partEnd,
+              RangeGetInitVariationBase_::initGet_(partBegin, partEnd, value));
+    }
+    return;
+  }
+  const auto coversNode = [&](std::size_t rangeIdx) {
+    return ranges[rangeIdx].first <= currBegin &&
+           rootEnd_(ranges[rangeIdx].second) >= currEnd;
+  };
+  const auto mid = impl::midpoint(currBegin, currEnd);
+  // Result of the whole subtree is calculated once for all covering ranges.
+  auto whole = std::optional<GetValueT>();
+  for (std::size_t i = first; i < last; ++i) {
+    if (coversNode(rangeIndices[i])) {
+      if (!whole.has_value()) {
+        whole = rangeGetImpl_(currBegin, currEnd, currBegin, currEnd,
+                              currNode, pending);
+      }
+      addPart(rangeIndices[i], currBegin, currEnd, *whole);
+    } else if (ranges[rangeIndices[i]].first < mid) {
+      rangeIndices.push_back(rangeIndices[i]);
+    }
+  }
+  pending.push(*currNode);
+  if (rangeIndices.size() > last) {
+    rangeGetBatchImpl_(ranges, out, rangeIndices, last, currBegin, mid,
+                       currNode->getLeft(), pending);
+    rangeIndices.resize(last);
+  }
+  for (std::size_t i = first; i < last; ++i) {
+    if (!coversNode(rangeIndices[i]) &&
+        rootEnd_(ranges[rangeIndices[i]].second) > mid) {
+      rangeIndices.push_back(rangeIndices[i]);
+    }
+  }
+  if (rangeIndices.size() > last) {
+    rangeGetBatchImpl_(ranges, out, rangeIndices, last, mid, currEnd,
+                       currNode->getRight(), pending);
+    rangeIndices.resize(last);
+  }
+  pending.pop(*currNode);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+template <class Pred>
+std::optional<KeyT>
+DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit, UpdateOp,
+                   UpdateArgT, Allocator, GetCachePolicy, UpdateCompose,
+                   CoalescePolicy>::
+    findFirstImpl_(KeyT begin, KeyT end, KeyT currBegin, KeyT currEnd,
+                   const Node_* currNode, Pred& pred,
+                   std::optional<GetValueT>& acc,
+                   PendingPath_& pending) const {
+  // Result on [begin, partEnd), where [partBegin, partEnd) has result `part`.
+  const auto withPart = [&](KeyT partBegin, KeyT partEnd,
+                            GetValueT part) -> GetValueT {
+    if (!acc.has_value()) {
+      return part;
+    }
+    return RangeGetCombineVariationBase_::combineGet_(*acc, part, begin,
+                                                      partBegin, partEnd);
+  };
+  if (currNode->isLeaf()) {
+    const auto& value =
+        UpdateVariationBase_::applyPending_(pending, currNode->getValue());
+    const KeyT partBegin = std::max(currBegin, begin);
+    const KeyT partEnd = std::min(currEnd, end);
+    const auto prefixUpTo = [&](KeyT last) {
+      return withPart(
+          partBegin, last,
+          RangeGetInitVariationBase_::initGet_(partBegin, last, value));
+    };
+    GetValueT whole = prefixUpTo(partEnd);
+    if (!pred(std::as_const(whole))) {
+      acc = std::move(whole);
+      return std::nullopt;
+    }
+    // The predicate is true on a prefix ending with `high`.
+    KeyT low = partBegin;
+    KeyT high = partEnd - 1;
+    while (low < high) {
+      const auto mid =
+          static_cast<KeyT>(low + impl::keyDistance(low, high) / 2);
+      if (pred(prefixUpTo(mid + 1))) {
+        high = mid;
+      } else {
+        low = mid + 1;
+      }
+    }
+    return low;
+  }
+  if constexpr (kCacheRangeGet_) {
+    if (end >= currEnd && begin <= currBegin) {
+      // Cached result does not include updates delayed in ancestors.
+      GetValueT whole = withPart(
+          currBegin, currEnd,
+          UpdateVariationBase_::applyPendingToGet_(
+              pending, currNode->getCachedGet(), currBegin, currEnd));
+      if (!pred(std::as_const(whole))) {
+        acc = std::move(whole);
+        return std::nullopt;
+      }
+    }
+  }
 
-  UpdateVariationBase_::optionalSiftNodeUpdate_(currNode, nodeAllocator_);
-  const auto mid = (currBegin + currEnd) / 2;
+  pending.push(*currNode);
+  const auto mid = impl::midpoint(currBegin, currEnd);
+  auto ret = std::optional<KeyT>();
+  if (begin < mid) {
+    ret = findFirstImpl_(begin, end, currBegin, mid, currNode->getLeft(), pred,
+                         acc, pending);
+  }
+  if (!ret.has_value() && end > mid) {
+    ret = findFirstImpl_(begin, end, mid, currEnd, currNode->getRight(), pred,
+                         acc, pending);
+  }
+  pending.pop(*currNode);
+  return ret;
+}
 
-  if (begin >= mid) {  // only right
-    return rangeGetImpl_(begin, end, mid, currEnd, currNode->getRight());
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+template <class Compare>
+std::pair<KeyT, ValueT>
+DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit, UpdateOp,
+                   UpdateArgT, Allocator, GetCachePolicy, UpdateCompose,
+                   CoalescePolicy>::rangeArgExtreme_(KeyT begin,
+                                                     KeyT end) const {
+  const bool withLastKey = reachesLastKey_(end);
+  begin = std::max(begin, begin_);
+  end = std::min(rootEnd_(end), end_);
+  if (begin >= end && !withLastKey) {
+    throw std::out_of_range("Range has no keys of a working area.");
+  }
+  auto best = std::optional<std::pair<KeyT, ValueT>>();
+  if (begin < end) {
+    PendingPath_ pending;
+    rangeArgExtremeImpl_<Compare>(begin, end, begin_, end_, &rootNode_, best,
+                                  pending);
+  }
+  // The maximal key is the last one, so it wins only with a better value.
+  if (withLastKey &&
+      (!best.has_value() || Compare{}(*lastKey_, best->second))) {
+    best.emplace(end_, *lastKey_);
   }
+  return std::move(*best);
+}
 
-  if (end <= mid) {  // only left
-    return rangeGetImpl_(begin, end, currBegin, mid, currNode->getLeft());
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+template <class Compare>
+void DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                        UpdateOp, UpdateArgT, Allocator, GetCachePolicy,
+                        UpdateCompose, CoalescePolicy>::
+    rangeArgExtremeImpl_(KeyT begin, KeyT end, KeyT currBegin, KeyT currEnd,
+                         const Node_* currNode,
+                         std::optional<std::pair<KeyT, ValueT>>& best,
+                         PendingPath_& pending) const {
+  constexpr auto kComp = Compare{};
+  if (currNode->isLeaf()) {
+    // Ties are kept with the left key.
+    const auto& value =
+        UpdateVariationBase_::applyPending_(pending, currNode->getValue());
+    if (!best.has_value() || kComp(value, best->second)) {
+      best.emplace(std::max(currBegin, begin), value);
+    }
+    return;
+  }
+  if constexpr (kCachedExtreme_<Compare>) {
+    // Cached result does not include updates delayed in ancestors.
+    if (end >= currEnd && begin <= currBegin && best.has_value() &&
+        !kComp(UpdateVariationBase_::applyPendingToGet_(
+                   pending, currNode->getCachedGet(), currBegin, currEnd),
+               best->second)) {
+      return;
+    }
   }
 
-  Node_* const rightNodePtr = currNode->getRight();
-  Node_* const leftNodePtr = currNode->getLeft();
-  const GetValueT rVal = rangeGetImpl_(begin, end, mid, currEnd, rightNodePtr);
-  const GetValueT lVal = rangeGetImpl_(begin, end, currBegin, mid, leftNodePtr);
+  pending.push(*currNode);
+  const auto mid = impl::midpoint(currBegin, currEnd);
+  if (begin < mid) {
+    rangeArgExtremeImpl_<Compare>(begin, end, currBegin, mid,
+                                  currNode->getLeft(), best, pending);
+  }
+  if (end > mid) {
+    rangeArgExtremeImpl_<Compare>(begin, end, mid, currEnd,
+                                  currNode->getRight(), best, pending);
+  }
+  pending.pop(*currNode);
+}
 
-  return RangeGetCombineVariationBase_::combineGet_(
-      lVal, rVal, std::max(currBegin, begin), mid, std::min(currEnd, end));
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+template <class ModifyCovered, class ModifyLastKey>
+GetValueT DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                             UpdateOp, UpdateArgT, Allocator, GetCachePolicy,
+                             UpdateCompose, CoalescePolicy>::
+    modifyAndGet_(KeyT begin, KeyT end, const ModifyCovered& modify,
+                  const ModifyLastKey& modifyLastKey) {
+  if (reachesLastKey_(end)) {
+    if (begin >= end_) {
+      return modifyLastKey();
+    }
+    GetValueT ret = modifyAndGetImpl_(begin, end_, begin_, end_, &rootNode_,
+                                      modify);
+    return RangeGetCombineVariationBase_::combineGet_(ret, modifyLastKey(),
+                                                      begin, end_, end);
+  }
+  if (std::max(begin, begin_) >= std::min(end, end_)) {
+    throw std::out_of_range("Range has no keys of a working area.");
+  }
+  return modifyAndGetImpl_(begin, end, begin_, end_, &rootNode_, modify);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+template <class ModifyCovered>
+GetValueT DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                             UpdateOp, UpdateArgT, Allocator, GetCachePolicy,
+                             UpdateCompose, CoalescePolicy>::
+    modifyAndGetImpl_(KeyT begin, KeyT end, KeyT currBegin, KeyT currEnd,
+                      Node_* currNode, const ModifyCovered& modify) {
+  if (end >= currEnd && begin <= currBegin) {
+    // Delayed updates of ancestors are already pushed down to the node.
+    return modify(currNode, currBegin, currEnd);
+  }
+  if (currNode->isLeaf()) {
+    currNode->initChildren(nodeAllocator_);
+  }
+  UpdateVariationBase_::optionalSiftNodeUpdate_(currNode, currBegin, currEnd,
+                                                nodeAllocator_);
+  const auto mid = impl::midpoint(currBegin, currEnd);
+
+  GetValueT ret = [&]() -> GetValueT {
+    if (begin >= mid) {  // only right
+      return modifyAndGetImpl_(begin, end, mid, currEnd, currNode->getRight(),
+                               modify);
+    }
+    if (end <= mid) {  // only left
+      return modifyAndGetImpl_(begin, end, currBegin, mid, currNode->getLeft(),
+                               modify);
+    }
+    const GetValueT lVal = modifyAndGetImpl_(begin, end, currBegin, mid,
+                                             currNode->getLeft(), modify);
+    const GetValueT rVal = modifyAndGetImpl_(begin, end, mid, currEnd,
+                                             currNode->getRight(), modify);
+    return RangeGetCombineVariationBase_::combineGet_(
+        lVal, rVal, std::max(currBegin, begin), mid, std::min(currEnd, end));
+  }();
+
+  afterChildrenChanged_(currNode, currBegin, mid, currEnd);
+  return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+void DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                        UpdateOp, UpdateArgT, Allocator, GetCachePolicy,
+                        UpdateCompose, CoalescePolicy>::
+    afterChildrenChanged_(Node_* currNode, KeyT currBegin, KeyT mid,
+                          KeyT currEnd) {
+  if constexpr (kCoalesceLeaves_) {
+    const Node_* const leftNodePtr = currNode->getLeft();
+    const Node_* const rightNodePtr = currNode->getRight();
+    if (leftNodePtr->isLeaf() && rightNodePtr->isLeaf() &&
+        leftNodePtr->getValue() == rightNodePtr->getValue()) {
+      currNode->coalesceChildren(nodeAllocator_);
+      return;
+    }
+  }
+  optionalRecalcNodeGetCache_(currNode, currBegin, mid, currEnd);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+void DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                        UpdateOp, UpdateArgT, Allocator, GetCachePolicy,
+                        UpdateCompose,
+                        CoalescePolicy>::throwGetOutOfRange_(KeyT key) {
+  std::stringstream messageStream;
+  messageStream << "Get operation for " << key << ", which is out of range.";
+  throw std::out_of_range(messageStream.str());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+void DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                        UpdateOp, UpdateArgT, Allocator, GetCachePolicy,
+                        UpdateCompose, CoalescePolicy>::
+    collectShape_(const Node_* currNode, std::vector<bool>& internal,
+                  std::vector<bool>& pending) const {
+  internal.push_back(!currNode->isLeaf());
+  if constexpr (std::is_same_v<UpdateOp, NoUpdateOp>) {
+    pending.push_back(false);
+  } else {
+    pending.push_back(currNode->hasPendingUpdate());
+  }
+  if (!currNode->isLeaf()) {
+    collectShape_(currNode->getLeft(), internal, pending);
+    collectShape_(currNode->getRight(), internal, pending);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+void DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                        UpdateOp, UpdateArgT, Allocator, GetCachePolicy,
+                        UpdateCompose, CoalescePolicy>::
+    writeNodes_(const Node_* currNode, std::ostream& out) const {
+  if (currNode->isLeaf()) {
+    Serializer<ValueT>::write(out, currNode->getValue());
+    return;
+  }
+  writeNodes_(currNode->getLeft(), out);
+  writeNodes_(currNode->getRight(), out);
+  if constexpr (!std::is_same_v<UpdateOp, NoUpdateOp> &&
+                !std::is_void_v<UpdateArgT>) {
+    if (currNode->hasPendingUpdate()) {
+      Serializer<UpdateArgT>::write(out, currNode->getPendingUpdate());
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+void DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                        UpdateOp, UpdateArgT, Allocator, GetCachePolicy,
+                        UpdateCompose, CoalescePolicy>::
+    readNodes_(std::istream& in, const std::vector<bool>& internal,
+               const std::vector<bool>& pending, std::size_t& nodeIdx,
+               KeyT currBegin, KeyT currEnd, Node_* currNode, bool leftmost) {
+  if (nodeIdx >= internal.size() ||
+      (internal[nodeIdx] && impl::keyDistance(currBegin, currEnd) < 2)) {
+    throw std::runtime_error("Serialized tree shape is corrupted.");
+  }
+  const bool isInternal = internal[nodeIdx];
+  [[maybe_unused]] const bool hasPending = pending[nodeIdx];
+  ++nodeIdx;
+  if (!isInternal) {
+    // The leftmost leaf value is read before construction.
+    if (!leftmost) {
+      currNode->setValue(Serializer<ValueT>::read(in), nodeAllocator_);
+      impl::checkReadStream(in);
+    }
+    return;
+  }
+  currNode->initChildren(nodeAllocator_);
+  const auto mid = impl::midpoint(currBegin, currEnd);
+  readNodes_(in, internal, pending, nodeIdx, currBegin, mid,
+             currNode->getLeft(), leftmost);
+  readNodes_(in, internal, pending, nodeIdx, mid, currEnd,
+             currNode->getRight(), false);
+  optionalRecalcNodeGetCache_(currNode, currBegin, mid, currEnd);
+  if constexpr (!std::is_same_v<UpdateOp, NoUpdateOp>) {
+    if (hasPending) {
+      if constexpr (std::is_void_v<UpdateArgT>) {
+        currNode->setPendingUpdate();
+      } else {
+        currNode->setPendingUpdate(Serializer<UpdateArgT>::read(in));
+        impl::checkReadStream(in);
+      }
+      if constexpr (kCacheRangeGet_) {
+        // Cached result includes the node own delayed update.
+        PendingPath_ own;
+        own.push(*currNode);
+        currNode->setCachedGet(UpdateVariationBase_::applyPendingToGet_(
+            own, currNode->getCachedGet(), currBegin, currEnd));
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator,
+          conc::RangeGetCachePolicy<KeyT, GetValueT, SegGetComb, SegGetInit,
+                                    UpdateOp, UpdateArgT> GetCachePolicy,
+          conc::OptUpdateCompose<ValueT, UpdateOp, UpdateArgT> UpdateCompose,
+          conc::LeafCoalescePolicy<ValueT> CoalescePolicy>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+void DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                        UpdateOp, UpdateArgT, Allocator, GetCachePolicy,
+                        UpdateCompose,
+                        CoalescePolicy>::
+    optionalRecalcNodeGetCache_(Node_* currNode, KeyT currBegin, KeyT mid,
+                                KeyT currEnd) const {
+  if constexpr (kCacheRangeGet_) {
+    const Node_* const leftNodePtr = currNode->getLeft();
+    const Node_* const rightNodePtr = currNode->getRight();
+    const GetValueT lVal =
+        leftNodePtr->isLeaf()
+            ? RangeGetInitVariationBase_::initGet_(currBegin, mid,
+                                                   leftNodePtr->getValue())
+            : leftNodePtr->getCachedGet();
+    const GetValueT rVal =
+        rightNodePtr->isLeaf()
+            ? RangeGetInitVariationBase_::initGet_(mid, currEnd,
+                                                   rightNodePtr->getValue())
+            : rightNodePtr->getCachedGet();
+    currNode->setCachedGet(RangeGetCombineVariationBase_::combineGet_(
+        lVal, rVal, currBegin, mid, currEnd));
+  }
 }
 
 }  // namespace dst
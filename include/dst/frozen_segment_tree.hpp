@@ -0,0 +1,397 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright Georgy Guminov 2023-2024.
+// Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt
+// or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef FROZEN_SEGMENT_TREE_HPP
+#define FROZEN_SEGMENT_TREE_HPP
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <dst/concepts.hpp>
+#include <dst/disable_operations.hpp>
+#include <dst/impl/dynamic_segment_tree_range_get_variation_base.hpp>
+#include <dst/key_range.hpp>
+#include <iterator>
+#include <limits>
+#include <ostream>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace dst {
+
+namespace impl {
+
+constexpr auto kFrozenMagic = std::array<char, 4>{'D', 'S', 'T', 'F'};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief The FrozenHeader<KeyT> class. Beginning of a frozen tree image.
+template <class KeyT>
+struct FrozenHeader {
+  std::array<char, 4> magic;
+  std::uint32_t nodeSize;
+  std::uint64_t nodesCount;
+  KeyT begin;
+  KeyT end;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief The FrozenNode<ValueT> class. Node of a frozen tree image.
+///
+/// Children are stored next to each other. `children` is an index of the left
+/// child, zero for a leaf. `value` is meaningful only for leaves.
+///
+template <class ValueT>
+struct FrozenNode {
+  ValueT value;
+  std::uint32_t children;
+};
+
+}  // namespace impl
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief The FrozenSegmentTree class. Read-only view of a tree image.
+///
+/// \tparam KeyT integral key type.
+/// \tparam ValueT trivially copyable value type.
+/// \tparam GetValueT type of a value returned from rangeGet operation.
+/// \tparam SegGetComb two segments combiner for rangeGet operation (see
+/// DynamicSegmentTree).
+/// \tparam SegGetInit rangeGet operation initializer (see
+/// DynamicSegmentTree).
+///
+/// An image is made from a DynamicSegmentTree by `freeze`. It has no
+/// pointers, so it can be written to a file and later mapped into memory
+/// and queried without deserialization. Pending updates are applied while
+/// freezing. Images are not portable between platforms with different byte
+/// order or type layouts. The view does not own the image.
+///
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb = NoRangeGetOp,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit =
+              NoRangeGetOp>
+  requires std::is_trivially_copyable_v<ValueT>
+class FrozenSegmentTree
+    : protected impl::DynamicSegmentTreeRangeGetCombineVariationBase<
+          KeyT, GetValueT, SegGetComb>,
+      protected impl::DynamicSegmentTreeRangeGetInitVariationBase<
+          KeyT, ValueT, GetValueT, SegGetInit> {
+ private:
+  using RangeGetCombineVariationBase_ =
+      impl::DynamicSegmentTreeRangeGetCombineVariationBase<KeyT, GetValueT,
+                                                           SegGetComb>;
+
+  using RangeGetInitVariationBase_ =
+      impl::DynamicSegmentTreeRangeGetInitVariationBase<KeyT, ValueT,
+                                                        GetValueT, SegGetInit>;
+
+  using Header_ = impl::FrozenHeader<KeyT>;
+  using Node_ = impl::FrozenNode<ValueT>;
+
+  // Nodes follow the header aligned for Node_.
+  constexpr static std::size_t kNodesOffset_ =
+      (sizeof(Header_) + alignof(Node_) - 1) / alignof(Node_) * alignof(Node_);
+
+ public:
+  /**
+   * @brief Construct a view of a frozen tree image.
+   *
+   * @param image bytes written by `freeze`. Must be aligned for ValueT and
+   * outlive the view.
+   * @param segGetComb functor called when two segments are combined in
+   * range get operation.
+   * @param segGetInit functor called for get result initialization on an
+   * equally filled segment.
+   * @throws std::invalid_argument if image is not a valid frozen tree. The
+   * shape of all nodes is checked once here, so a corrupted image can not
+   * make queries read out of it.
+   */
+  explicit FrozenSegmentTree(std::span<const std::byte> image,
+                             const SegGetComb& segGetComb = SegGetComb{},
+                             const SegGetInit& segGetInit = SegGetInit{});
+
+  /**
+   * @brief Write an image of a tree.
+   *
+   * @param tree a DynamicSegmentTree with the same KeyT and ValueT.
+   * @param out output stream.
+   * @throws std::invalid_argument if `tree` has an empty working area, or if
+   * it is built over all keys, an image has no place for the maximal key.
+   */
+  template <class Tree>
+  static void freeze(const Tree& tree, std::ostream& out);
+
+  /**
+   * @brief Get value by index.
+   *
+   * @param key index.
+   * @return value in index.
+   */
+  const ValueT& get(KeyT key) const;
+
+  /**
+   * @brief Get result on a range.
+   *
+   * @param begin beginning of a range.
+   * @param end ending of a range.
+   * @return range get operation result.
+   */
+  GetValueT rangeGet(KeyT begin, KeyT end) const
+    requires conc::GetCombiner<SegGetComb, GetValueT, KeyT> &&
+             conc::GetInitializer<SegGetInit, ValueT, KeyT, GetValueT>;
+
+  [[nodiscard]] std::size_t nodesCount() const {
+    return nodes_.size();
+  }
+
+ private:
+  template <class LeafIt>
+  static void freezeImpl_(std::vector<Node_>& nodes, std::uint32_t currIdx,
+                          KeyT currBegin, KeyT currEnd, LeafIt& leafIt);
+  GetValueT rangeGetImpl_(KeyT begin, KeyT end, KeyT currBegin, KeyT currEnd,
+                          std::uint32_t currIdx) const;
+  void checkNodes_(std::uint32_t currIdx, KeyT currBegin, KeyT currEnd,
+                   std::uint64_t& nextIdx) const;
+
+ private:
+  std::span<const Node_> nodes_;
+  KeyT begin_;
+  KeyT end_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit>
+  requires std::is_trivially_copyable_v<ValueT>
+FrozenSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit>::
+    FrozenSegmentTree(std::span<const std::byte> image,
+                      const SegGetComb& segGetComb,
+                      const SegGetInit& segGetInit)
+    : RangeGetCombineVariationBase_(segGetComb),
+      RangeGetInitVariationBase_(segGetInit) {
+  if (image.size() < kNodesOffset_) {
+    throw std::invalid_argument("Frozen tree image is too short.");
+  }
+  auto header = Header_();
+  std::memcpy(&header, image.data(), sizeof(Header_));
+  if (header.magic != impl::kFrozenMagic ||
+      header.nodeSize != sizeof(Node_) || header.nodesCount == 0 ||
+      header.begin >= header.end) {
+    throw std::invalid_argument("Not a frozen tree image of this type.");
+  }
+  if ((image.size() - kNodesOffset_) / sizeof(Node_) < header.nodesCount) {
+    throw std::invalid_argument("Frozen tree image is too short.");
+  }
+  const std::byte* const nodesData = image.data() + kNodesOffset_;
+  if (reinterpret_cast<std::uintptr_t>(nodesData) % alignof(Node_) != 0) {
+    throw std::invalid_argument("Frozen tree image is misaligned.");
+  }
+  nodes_ = std::span(reinterpret_cast<const Node_*>(nodesData),  // NOLINT
+                     header.nodesCount);
+  begin_ = header.begin;
+  end_ = header.end;
+  auto nextIdx = std::uint64_t{1};
+  checkNodes_(0, begin_, end_, nextIdx);
+  if (nextIdx != nodes_.size()) {
+    throw std::invalid_argument("Frozen tree image is corrupted.");
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit>
+  requires std::is_trivially_copyable_v<ValueT>
+template <class Tree>
+void FrozenSegmentTree<KeyT, ValueT, GetValueT, SegGetComb,
+                       SegGetInit>::freeze(const Tree& tree,
+                                           std::ostream& out) {
+  const auto leaves = tree.leaves();
+  auto leafIt = std::ranges::begin(leaves);
+  if (leafIt == std::ranges::end(leaves)) {
+    throw std::invalid_argument(
+        "Tree with an empty working area can not be frozen.");
+  }
+  const KeyT begin = (*leafIt).begin;
+  auto nodes = std::vector<Node_>{Node_{(*leafIt).value, 0}};
+  auto end = begin;
+  for (const auto& leaf : leaves) {
+    if (leaf.end <= leaf.begin) {
+      throw std::invalid_argument(
+          "Maximal key of a tree over all keys can not be frozen.");
+    }
+    end = leaf.end;
+  }
+  freezeImpl_(nodes, 0, begin, end, leafIt);
+
+  auto header = Header_{};
+  header.magic = impl::kFrozenMagic;
+  header.nodeSize = sizeof(Node_);
+  header.nodesCount = nodes.size();
+  header.begin = begin;
+  header.end = end;
+  auto headerBytes = std::array<char, kNodesOffset_>{};
+  std::memcpy(headerBytes.data(), &header, sizeof(Header_));
+  out.write(headerBytes.data(), headerBytes.size());
+  out.write(reinterpret_cast<const char*>(nodes.data()),  // NOLINT
+            static_cast<std::streamsize>(nodes.size() * sizeof(Node_)));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit>
+  requires std::is_trivially_copyable_v<ValueT>
+const ValueT&
+FrozenSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit>::get(
+    KeyT key) const {
+  if (key >= end_ || key < begin_) {
+    std::stringstream messageStream;
+    messageStream << "Get operation for " << key << ", which is out of range.";
+    throw std::out_of_range(messageStream.str());
+  }
+  auto currIdx = std::uint32_t{0};
+  KeyT currBegin = begin_;
+  KeyT currEnd = end_;
+  while (nodes_[currIdx].children != 0) {
+    if (const auto mid = impl::midpoint(currBegin, currEnd); key >= mid) {
+      currBegin = mid;
+      currIdx = nodes_[currIdx].children + 1;
+    } else {
+      currEnd = mid;
+      currIdx = nodes_[currIdx].children;
+    }
+  }
+  return nodes_[currIdx].value;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit>
+  requires std::is_trivially_copyable_v<ValueT>
+GetValueT
+FrozenSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit>::rangeGet(
+    KeyT begin, KeyT end) const
+  requires conc::GetCombiner<SegGetComb, GetValueT, KeyT> &&
+           conc::GetInitializer<SegGetInit, ValueT, KeyT, GetValueT>
+{
+  return rangeGetImpl_(begin, end, begin_, end_, 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit>
+  requires std::is_trivially_copyable_v<ValueT>
+template <class LeafIt>
+void FrozenSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit>::
+    freezeImpl_(std::vector<Node_>& nodes, std::uint32_t currIdx,
+                KeyT currBegin, KeyT currEnd, LeafIt& leafIt) {
+  const auto& leaf = *leafIt;
+  if (leaf.begin == currBegin && leaf.end == currEnd) {
+    nodes[currIdx].value = leaf.value;
+    ++leafIt;
+    return;
+  }
+  if (nodes.size() + 2 > std::numeric_limits<std::uint32_t>::max()) {
+    throw std::length_error("Too many nodes for a frozen tree.");
+  }
+  const auto leftIdx = static_cast<std::uint32_t>(nodes.size());
+  nodes[currIdx].children = leftIdx;
+  nodes.push_back(Node_{leaf.value, 0});
+  nodes.push_back(Node_{leaf.value, 0});
+  const auto mid = impl::midpoint(currBegin, currEnd);
+  freezeImpl_(nodes, leftIdx, currBegin, mid, leafIt);
+  freezeImpl_(nodes, leftIdx + 1, mid, currEnd, leafIt);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit>
+  requires std::is_trivially_copyable_v<ValueT>
+GetValueT
+FrozenSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit>::
+    rangeGetImpl_(KeyT begin, KeyT end, KeyT currBegin, KeyT currEnd,
+                  std::uint32_t currIdx) const {
+  const Node_& currNode = nodes_[currIdx];
+  if (currNode.children == 0) {
+    return RangeGetInitVariationBase_::initGet_(
+        std::max(currBegin, begin), std::min(currEnd, end), currNode.value);
+  }
+  const auto mid = impl::midpoint(currBegin, currEnd);
+  if (begin >= mid) {  // only right
+    return rangeGetImpl_(begin, end, mid, currEnd, currNode.children + 1);
+  }
+  if (end <= mid) {  // only left
+    return rangeGetImpl_(begin, end, currBegin, mid, currNode.children);
+  }
+  const GetValueT lVal =
+      rangeGetImpl_(begin, end, currBegin, mid, currNode.children);
+  const GetValueT rVal =
+      rangeGetImpl_(begin, end, mid, currEnd, currNode.children + 1);
+  return RangeGetCombineVariationBase_::combineGet_(
+      lVal, rVal, std::max(currBegin, begin), mid, std::min(currEnd, end));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit>
+  requires std::is_trivially_copyable_v<ValueT>
+void FrozenSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit>::
+    checkNodes_(std::uint32_t currIdx, KeyT currBegin, KeyT currEnd,
+                std::uint64_t& nextIdx) const {
+  const std::uint32_t children = nodes_[currIdx].children;
+  if (children == 0) {
+    return;
+  }
+  // freeze places children pairs in the order of this walk, so each node is
+  // reached once. Segments of internal nodes have at least two keys, so the
+  // walk is not deeper than a valid tree.
+  if (children != nextIdx || nextIdx + 1 >= nodes_.size() ||
+      impl::keyDistance(currBegin, currEnd) < 2) {
+    throw std::invalid_argument("Frozen tree image is corrupted.");
+  }
+  nextIdx += 2;
+  const auto mid = impl::midpoint(currBegin, currEnd);
+  checkNodes_(children, currBegin, mid, nextIdx);
+  checkNodes_(children + 1, mid, currEnd, nextIdx);
+}
+
+namespace impl {
+
+////////////////////////////////////////////////////////////////////////////////
+template <class Tree>
+struct FrozenSegmentTreeFor;
+
+template <template <class...> class Tree, class KeyT, class ValueT,
+          class GetValueT, class SegGetComb, class SegGetInit, class... Rest>
+struct FrozenSegmentTreeFor<
+    Tree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit, Rest...>> {
+  using Type =
+      FrozenSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit>;
+};
+
+}  // namespace impl
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief FrozenSegmentTree type for a DynamicSegmentTree type with the same
+/// keys, values and range get operation.
+template <class Tree>
+using FrozenSegmentTreeFor = impl::FrozenSegmentTreeFor<Tree>::Type;
+
+}  // namespace dst
+
+#endif  // FROZEN_SEGMENT_TREE_HPP
@@ -7,9 +7,14 @@
 #ifndef DYNAMIC_SEGMENT_TREE_UPDATE_VARIATION_BASE_HPP
 #define DYNAMIC_SEGMENT_TREE_UPDATE_VARIATION_BASE_HPP
 
+#include <cassert>
 #include <dst/concepts.hpp>
 #include <dst/disable_operations.hpp>
 #include <dst/impl/node.hpp>
+#include <dst/impl/pending.hpp>
+#include <dst/key_range.hpp>
+#include <dst/mp.hpp>
+#include <type_traits>
 
 namespace dst::impl {
 
@@ -19,20 +24,49 @@ namespace dst::impl {
 template <class Derived>
 class DynamicSegmentTreeUpdateVariationBase;
 
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Update of cached rangeGet results of a segment and of its halves
+/// (see NoCacheUpdate).
+template <class CacheUpdateOp, class KeyT>
+struct SegmentCacheUpdate {
+  const CacheUpdateOp* op;
+  KeyT begin;
+  KeyT end;
+
+  template <class GetValueT, class... UpdateArgs>
+  GetValueT operator()(const GetValueT& cached,
+                       const UpdateArgs&... args) const {
+    return (*op)(cached, args..., begin, end);
+  }
+
+  [[nodiscard]] SegmentCacheUpdate left() const {
+    return {op, begin, midpoint(begin, end)};
+  }
+
+  [[nodiscard]] SegmentCacheUpdate right() const {
+    return {op, midpoint(begin, end), end};
+  }
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 template <template <class...> class Derived, class KeyT, class ValueT,
           class GetValueT, class SegGetComb, class SegGetInit, class UpdateOp,
-          class UpdateArgT, class Allocator>
+          class UpdateArgT, class Allocator, class GetCachePolicy,
+          class UpdateCompose, class CoalescePolicy>
   requires conc::TwoArgsUpdateOp<UpdateOp, ValueT, UpdateArgT>
 class DynamicSegmentTreeUpdateVariationBase<
     Derived<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit, UpdateOp,
-            UpdateArgT, Allocator>> {
+            UpdateArgT, Allocator, GetCachePolicy, UpdateCompose,
+            CoalescePolicy>> {
  protected:
   using Derived_ = Derived<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
-                           UpdateOp, UpdateArgT, Allocator>;
-  using Node_ = Node<ValueT, std::optional<UpdateArgT>, Allocator>;
+                           UpdateOp, UpdateArgT, Allocator, GetCachePolicy,
+                           UpdateCompose, CoalescePolicy>;
+  using Node_ = Node<ValueT, std::optional<UpdateArgT>, Allocator,
+                     mp::NodeGetCacheT<GetCachePolicy, GetValueT>>;
   using NodeAlloc_ =
       std::allocator_traits<Allocator>::template rebind_alloc<Node_>;
+  using CacheUpdateOp_ = mp::CacheUpdateT<GetCachePolicy>;
 
  public:
   /**
@@ -44,6 +78,20 @@ class DynamicSegmentTreeUpdateVariationBase<
    */
   void update(KeyT begin, KeyT end, const UpdateArgT& toUpdate);
 
+  /**
+   * @brief Apply one argument operation on a range and get result on the
+   * range after it in the same descent.
+   *
+   * @param begin beginning of an updated segment.
+   * @param end ending of an updated segment (not included).
+   * @param toUpdate argument for update operation.
+   * @return range get operation result after the update.
+   * @throws std::out_of_range if a range has no keys of a working area.
+   */
+  GetValueT updateAndGet(KeyT begin, KeyT end, const UpdateArgT& toUpdate)
+    requires conc::GetCombiner<SegGetComb, GetValueT, KeyT> &&
+             conc::GetInitializer<SegGetInit, ValueT, KeyT, GetValueT>;
+
  protected:
   explicit DynamicSegmentTreeUpdateVariationBase(const UpdateOp& updateOp)
       : updateOp_(updateOp) {
@@ -54,75 +102,143 @@ class DynamicSegmentTreeUpdateVariationBase<
                    Node_* currNode, const UpdateArgT& toUpdate,
                    NodeAlloc_& allocator);
 
-  void optionalSiftNodeUpdate_(Node_* nodePtr, NodeAlloc_& allocator) const {
-    nodePtr->siftOptUpdate(updateOp_, allocator);
+  void optionalSiftNodeUpdate_(Node_* nodePtr, KeyT begin, KeyT end,
+                               NodeAlloc_& allocator) const {
+    nodePtr->siftOptUpdate(updateOp_, allocator, updateCompose_,
+                           cacheUpdateOn_(begin, end));
+  }
+
+  /**
+   * @brief Update of cached rangeGet results of a segment.
+   */
+  auto cacheUpdateOn_(KeyT begin, KeyT end) const {
+    if constexpr (std::is_same_v<CacheUpdateOp_, NoUpdateOp>) {
+      return NoCacheUpdate{};
+    } else {
+      return SegmentCacheUpdate<CacheUpdateOp_, KeyT>{&cacheUpdateOp_, begin,
+                                                      end};
+    }
+  }
+
+  using PendingPath_ = PendingPath<UpdateOp, ValueT, UpdateArgT, KeyT>;
+
+  ValueT applyPending_(const PendingPath_& path, const ValueT& value) const {
+    return path.apply(updateOp_, value);
+  }
+
+  template <class CacheT>
+  CacheT applyPendingToGet_(const PendingPath_& path, const CacheT& cached,
+                            KeyT begin, KeyT end) const {
+    return path.applyToGet(cacheUpdateOp_, cached, begin, end);
   }
 
  private:
   UpdateOp updateOp_;
+  [[no_unique_address]] UpdateCompose updateCompose_{};
+  [[no_unique_address]] CacheUpdateOp_ cacheUpdateOp_{};
 };
 
 ////////////////////////////////////////////////////////////////////////////////
 template <template <class...> class Derived, class KeyT, class ValueT,
           class GetValueT, class SegGetComb, class SegGetInit, class UpdateOp,
-          class UpdateArgT, class Allocator>
+          class UpdateArgT, class Allocator, class GetCachePolicy,
+          class UpdateCompose, class CoalescePolicy>
   requires conc::TwoArgsUpdateOp<UpdateOp, ValueT, UpdateArgT>
 void DynamicSegmentTreeUpdateVariationBase<
     Derived<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit, UpdateOp,
-            UpdateArgT, Allocator>>::update(KeyT begin, KeyT end,
-                                            const UpdateArgT& toUpdate) {
-  updateImpl_(begin, end, static_cast<Derived_*>(this)->begin_,
-              static_cast<Derived_*>(this)->end_,
-              &static_cast<Derived_*>(this)->rootNode_, toUpdate,
-              static_cast<Derived_*>(this)->nodeAllocator_);
+            UpdateArgT, Allocator, GetCachePolicy, UpdateCompose,
+            CoalescePolicy>>::update(KeyT begin, KeyT end,
+                                     const UpdateArgT& toUpdate) {
+  auto* const tree = static_cast<Derived_*>(this);
+  if (tree->reachesLastKey_(end)) {
+    *tree->lastKey_ = updateOp_(*tree->lastKey_, toUpdate);
+  }
+  updateImpl_(begin, tree->rootEnd_(end), tree->begin_, tree->end_,
+              &tree->rootNode_, toUpdate, tree->nodeAllocator_);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 template <template <class...> class Derived, class KeyT, class ValueT,
           class GetValueT, class SegGetComb, class SegGetInit, class UpdateOp,
-          class UpdateArgT, class Allocator>
+          class UpdateArgT, class Allocator, class GetCachePolicy,
+          class UpdateCompose, class CoalescePolicy>
+  requires conc::TwoArgsUpdateOp<UpdateOp, ValueT, UpdateArgT>
+GetValueT DynamicSegmentTreeUpdateVariationBase<
+    Derived<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit, UpdateOp,
+            UpdateArgT, Allocator, GetCachePolicy, UpdateCompose,
+            CoalescePolicy>>::updateAndGet(KeyT begin, KeyT end,
+                                           const UpdateArgT& toUpdate)
+  requires conc::GetCombiner<SegGetComb, GetValueT, KeyT> &&
+           conc::GetInitializer<SegGetInit, ValueT, KeyT, GetValueT>
+{
+  auto* const tree = static_cast<Derived_*>(this);
+  return tree->modifyAndGet_(
+      begin, end, [&](Node_* node, KeyT nodeBegin, KeyT nodeEnd) {
+        node->update(updateOp_, toUpdate, tree->nodeAllocator_,
+                     updateCompose_, cacheUpdateOn_(nodeBegin, nodeEnd));
+        PendingPath_ pending;
+        return tree->rangeGetImpl_(nodeBegin, nodeEnd, nodeBegin, nodeEnd,
+                                   node, pending);
+      },
+      [&] {
+        *tree->lastKey_ = updateOp_(*tree->lastKey_, toUpdate);
+        return tree->lastKeyGet_();
+      });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <template <class...> class Derived, class KeyT, class ValueT,
+          class GetValueT, class SegGetComb, class SegGetInit, class UpdateOp,
+          class UpdateArgT, class Allocator, class GetCachePolicy,
+          class UpdateCompose, class CoalescePolicy>
   requires conc::TwoArgsUpdateOp<UpdateOp, ValueT, UpdateArgT>
 void DynamicSegmentTreeUpdateVariationBase<
     Derived<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit, UpdateOp,
-            UpdateArgT, Allocator>>::updateImpl_(KeyT begin, KeyT end,
-                                                 KeyT currBegin, KeyT currEnd,
-                                                 Node_* currNode,
-                                                 const UpdateArgT& toUpdate,
-                                                 NodeAlloc_& allocator) {
+            UpdateArgT, Allocator, GetCachePolicy, UpdateCompose,
+            CoalescePolicy>>::updateImpl_(KeyT begin, KeyT end,
+                                          KeyT currBegin, KeyT currEnd,
+                                          Node_* currNode,
+                                          const UpdateArgT& toUpdate,
+                                          NodeAlloc_& allocator) {
   if (begin >= currEnd || currBegin >= end) {
     return;
   }
   if (end >= currEnd && begin <= currBegin) {
-    currNode->update(updateOp_, toUpdate, allocator);
+    currNode->update(updateOp_, toUpdate, allocator, updateCompose_,
+                     cacheUpdateOn_(currBegin, currEnd));
     return;
   }
   if (currNode->isLeaf()) {
     currNode->initChildren(allocator);
   }
-  if constexpr (conc::UpdateOp<UpdateOp, ValueT, UpdateArgT>) {
-    currNode->siftOptUpdate(updateOp_, allocator);
-  }
+  optionalSiftNodeUpdate_(currNode, currBegin, currEnd, allocator);
   assert(currEnd >= currBegin + 2);
-  const auto mid = (currBegin + currEnd) / 2;
+  const auto mid = midpoint(currBegin, currEnd);
   updateImpl_(begin, end, currBegin, mid, currNode->getLeft(), toUpdate,
               allocator);
   updateImpl_(begin, end, mid, currEnd, currNode->getRight(), toUpdate,
               allocator);
+  static_cast<Derived_*>(this)->afterChildrenChanged_(currNode, currBegin, mid,
+                                                     currEnd);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 template <template <class...> class Derived, class KeyT, class ValueT,
           class GetValueT, class SegGetComb, class SegGetInit,
-          conc::OneArgUpdateOp<ValueT> UpdateOp, class Allocator>
+          conc::OneArgUpdateOp<ValueT> UpdateOp, class Allocator,
+          class GetCachePolicy, class UpdateCompose, class CoalescePolicy>
 class DynamicSegmentTreeUpdateVariationBase<
     Derived<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit, UpdateOp, void,
-            Allocator>> {
+            Allocator, GetCachePolicy, UpdateCompose, CoalescePolicy>> {
  protected:
   using Derived_ = Derived<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
-                           UpdateOp, void, Allocator>;
-  using Node_ = Node<ValueT, bool, Allocator>;
+                           UpdateOp, void, Allocator, GetCachePolicy,
+                           UpdateCompose, CoalescePolicy>;
+  using Node_ = Node<ValueT, bool, Allocator,
+                     mp::NodeGetCacheT<GetCachePolicy, GetValueT>>;
   using NodeAlloc_ =
       std::allocator_traits<Allocator>::template rebind_alloc<Node_>;
+  using CacheUpdateOp_ = mp::CacheUpdateT<GetCachePolicy>;
 
  protected:
   explicit DynamicSegmentTreeUpdateVariationBase(const UpdateOp& updateOp)
@@ -137,46 +253,106 @@ class DynamicSegmentTreeUpdateVariationBase<
    * @param end ending of an updated segment (not included).
    */
   void update(KeyT begin, KeyT end) {
-    updateImpl_(begin, end, static_cast<Derived_*>(this)->begin_,
-                static_cast<Derived_*>(this)->end_,
-                &static_cast<Derived_*>(this)->rootNode_,
-                static_cast<Derived_*>(this)->nodeAllocator_);
+    auto* const tree = static_cast<Derived_*>(this);
+    if (tree->reachesLastKey_(end)) {
+      *tree->lastKey_ = updateOp_(*tree->lastKey_);
+    }
+    updateImpl_(begin, tree->rootEnd_(end), tree->begin_, tree->end_,
+                &tree->rootNode_, tree->nodeAllocator_);
+  }
+
+  /**
+   * @brief Apply no arguments update operation on a range and get result on
+   * the range after it in the same descent.
+   *
+   * @param begin beginning of an updated segment.
+   * @param end ending of an updated segment (not included).
+   * @return range get operation result after the update.
+   * @throws std::out_of_range if a range has no keys of a working area.
+   */
+  GetValueT updateAndGet(KeyT begin, KeyT end)
+    requires conc::GetCombiner<SegGetComb, GetValueT, KeyT> &&
+             conc::GetInitializer<SegGetInit, ValueT, KeyT, GetValueT>
+  {
+    auto* const tree = static_cast<Derived_*>(this);
+    return tree->modifyAndGet_(
+        begin, end, [&](Node_* node, KeyT nodeBegin, KeyT nodeEnd) {
+          node->update(updateOp_, tree->nodeAllocator_,
+                       cacheUpdateOn_(nodeBegin, nodeEnd));
+          PendingPath_ pending;
+          return tree->rangeGetImpl_(nodeBegin, nodeEnd, nodeBegin, nodeEnd,
+                                     node, pending);
+        },
+        [&] {
+          *tree->lastKey_ = updateOp_(*tree->lastKey_);
+          return tree->lastKeyGet_();
+        });
   }
 
  protected:
   template <class NodeAlloc>
   void updateImpl_(KeyT begin, KeyT end, KeyT currBegin, KeyT currEnd,
                    Node_* currNode, NodeAlloc& allocator);
-  void optionalSiftNodeUpdate_(Node_* nodePtr, NodeAlloc_& allocator) const {
-    nodePtr->siftOptUpdate(updateOp_, allocator);
+  void optionalSiftNodeUpdate_(Node_* nodePtr, KeyT begin, KeyT end,
+                               NodeAlloc_& allocator) const {
+    nodePtr->siftOptUpdate(updateOp_, allocator, cacheUpdateOn_(begin, end));
+  }
+
+  /**
+   * @brief Update of cached rangeGet results of a segment.
+   */
+  auto cacheUpdateOn_(KeyT begin, KeyT end) const {
+    if constexpr (std::is_same_v<CacheUpdateOp_, NoUpdateOp>) {
+      return NoCacheUpdate{};
+    } else {
+      return SegmentCacheUpdate<CacheUpdateOp_, KeyT>{&cacheUpdateOp_, begin,
+                                                      end};
+    }
+  }
+
+  using PendingPath_ = PendingPath<UpdateOp, ValueT, void, KeyT>;
+
+  ValueT applyPending_(const PendingPath_& path, const ValueT& value) const {
+    return path.apply(updateOp_, value);
+  }
+
+  template <class CacheT>
+  CacheT applyPendingToGet_(const PendingPath_& path, const CacheT& cached,
+                            KeyT begin, KeyT end) const {
+    return path.applyToGet(cacheUpdateOp_, cached, begin, end);
   }
 
  private:
   UpdateOp updateOp_;
+  [[no_unique_address]] CacheUpdateOp_ cacheUpdateOp_{};
 };
 
 ////////////////////////////////////////////////////////////////////////////////
 template <template <class...> class Derived, class KeyT, class ValueT,
           class GetValueT, class SegGetComb, class SegGetInit,
-          conc::OneArgUpdateOp<ValueT> UpdateOp, class Allocator>
+          conc::OneArgUpdateOp<ValueT> UpdateOp, class Allocator,
+          class GetCachePolicy, class UpdateCompose, class CoalescePolicy>
 template <class NodeAlloc>
 void DynamicSegmentTreeUpdateVariationBase<
     Derived<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit, UpdateOp, void,
-            Allocator>>::updateImpl_(KeyT begin, KeyT end, KeyT currBegin,
-                                     KeyT currEnd, Node_* currNode,
-                                     NodeAlloc& allocator) {
+            Allocator, GetCachePolicy, UpdateCompose,
+            CoalescePolicy>>::updateImpl_(KeyT begin, KeyT end,
+                                          KeyT currBegin, KeyT currEnd,
+                                          Node_* currNode,
+                                          NodeAlloc& allocator) {
   if (begin >= currEnd || currBegin >= end) {
     return;
   }
   if (end >= currEnd && begin <= currBegin) {
-    currNode->update(updateOp_, allocator);
+    currNode->update(updateOp_, allocator, cacheUpdateOn_(currBegin, currEnd));
     return;
   }
   if (currNode->isLeaf()) {
     currNode->initChildren(allocator);
   }
-  currNode->siftOptUpdate(updateOp_, allocator);
-  const auto mid = (currBegin + currEnd) / 2;
+  currNode->siftOptUpdate(updateOp_, allocator,
+                          cacheUpdateOn_(currBegin, currEnd));
+  const auto mid = midpoint(currBegin, currEnd);
   if (mid >= currBegin + 1) {
     auto* const leftNodePtr = currNode->getLeft();
     updateImpl_(begin, end, currBegin, mid, leftNodePtr, allocator);
@@ -185,16 +361,20 @@ void DynamicSegmentTreeUpdateVariationBase<
     auto* const rightNodePtr = currNode->getRight();
     updateImpl_(begin, end, mid, currEnd, rightNodePtr, allocator);
   }
+  static_cast<Derived_*>(this)->afterChildrenChanged_(currNode, currBegin, mid,
+                                                     currEnd);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 template <template <class...> class Derived, class KeyT, class ValueT,
-          class GetValueT, class SegGetComb, class SegGetInit, class Allocator>
+          class GetValueT, class SegGetComb, class SegGetInit, class Allocator,
+          class GetCachePolicy, class UpdateCompose, class CoalescePolicy>
 class DynamicSegmentTreeUpdateVariationBase<
     Derived<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit, NoUpdateOp, void,
-            Allocator>> {
+            Allocator, GetCachePolicy, UpdateCompose, CoalescePolicy>> {
  protected:
-  using Node_ = Node<ValueT, void, Allocator>;
+  using Node_ = Node<ValueT, void, Allocator,
+                     mp::NodeGetCacheT<GetCachePolicy, GetValueT>>;
   using NodeAlloc_ =
       std::allocator_traits<Allocator>::template rebind_alloc<Node_>;
 
@@ -202,7 +382,20 @@ class DynamicSegmentTreeUpdateVariationBase<
   explicit DynamicSegmentTreeUpdateVariationBase(NoUpdateOp){};
 
  protected:
-  void optionalSiftNodeUpdate_(Node_*, NodeAlloc_&) const {
+  void optionalSiftNodeUpdate_(Node_*, KeyT, KeyT, NodeAlloc_&) const {
+  }
+
+  using PendingPath_ = PendingPath<NoUpdateOp, ValueT, void, KeyT>;
+
+  static const ValueT& applyPending_(const PendingPath_&,
+                                     const ValueT& value) {
+    return value;
+  }
+
+  template <class CacheT>
+  static const CacheT& applyPendingToGet_(const PendingPath_&,
+                                          const CacheT& cached, KeyT, KeyT) {
+    return cached;
   }
 };
 
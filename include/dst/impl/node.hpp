@@ -8,23 +8,28 @@
 #define NODE_HPP
 
 #include <cassert>
+#include <dst/disable_operations.hpp>
 #include <dst/impl/node_base.hpp>
+#include <dst/impl/pending.hpp>
+#include <dst/upd.hpp>
 #include <memory>
 #include <optional>
 #include <type_traits>
+#include <utility>
 
 namespace dst::impl {
 
 ////////////////////////////////////////////////////////////////////////////////
-template <class T, class UpdateT, class Allocator = std::allocator<T>>
+template <class T, class UpdateT, class Allocator = std::allocator<T>,
+          class GetCacheT = void>
 class Node;
 
 ////////////////////////////////////////////////////////////////////////////////
-template <class T, class UpdateT, class Allocator>
-class Node<T, std::optional<UpdateT>, Allocator>
-    : public BaseNode<Node<T, std::optional<UpdateT>, Allocator>> {
+template <class T, class UpdateT, class Allocator, class GetCacheT>
+class Node<T, std::optional<UpdateT>, Allocator, GetCacheT>
+    : public BaseNode<Node<T, std::optional<UpdateT>, Allocator, GetCacheT>> {
  private:
-  using This_ = Node<T, std::optional<UpdateT>, Allocator>;
+  using This_ = Node<T, std::optional<UpdateT>, Allocator, GetCacheT>;
   using Base_ = BaseNode<This_>;
   using Allocator_ =
       std::allocator_traits<Allocator>::template rebind_alloc<This_>;
@@ -41,6 +46,10 @@ class Node<T, std::optional<UpdateT>, Allocator>
 
   Node(const Node& node, Allocator_& allocator);
 
+  Node(const Node& node, ShallowCopyTag tag)
+      : Base_(node, tag), updateValue_(node.updateValue_) {
+  }
+
   Node(Node&& other) noexcept = default;
 
   Node& operator=(const Node& other) = delete;
@@ -58,12 +67,54 @@ class Node<T, std::optional<UpdateT>, Allocator>
     requires std::is_same_v<std::remove_cvref_t<ValueT>, T>
   void setValue(ValueT&& value, Allocator_& allocator);
 
-  template <class UpdateOp, class UpdateT1>
+  /**
+   * @brief Apply update to a leaf or delay it in an internal node.
+   *
+   * If an internal node already has a delayed update, it is pushed to
+   * children, or, if `updateCompose` is given, merged with the new one.
+   *
+   * @param updateOp update operation.
+   * @param update update operation argument.
+   * @param allocator nodes allocator.
+   * @param updateCompose composition of two update arguments.
+   * @param cacheUpdate update of cached rangeGet result of the node segment
+   * (see NoCacheUpdate).
+   */
+  template <class UpdateOp, class UpdateT1,
+            class UpdateCompose = NoUpdateCompose,
+            class CacheUpdate = NoCacheUpdate>
     requires std::is_same_v<std::remove_cvref_t<UpdateT1>, UpdateT>
   void update(const UpdateOp& updateOp, UpdateT1&& update,
-              Allocator_& allocator);
-  template <class UpdateOp>
-  void siftOptUpdate(const UpdateOp& updateOp, Allocator_& allocator);
+              Allocator_& allocator,
+              const UpdateCompose& updateCompose = UpdateCompose{},
+              const CacheUpdate& cacheUpdate = CacheUpdate{});
+  template <class UpdateOp, class UpdateCompose = NoUpdateCompose,
+            class CacheUpdate = NoCacheUpdate>
+  void siftOptUpdate(const UpdateOp& updateOp, Allocator_& allocator,
+                     const UpdateCompose& updateCompose = UpdateCompose{},
+                     const CacheUpdate& cacheUpdate = CacheUpdate{});
+
+  [[nodiscard]] bool hasPendingUpdate() const {
+    return updateValue_.has_value();
+  }
+
+  /**
+   * @brief Get the delayed update argument. Must only be called if the node
+   * has one.
+   */
+  [[nodiscard]] const UpdateT& getPendingUpdate() const {
+    assert(hasPendingUpdate());
+    return *updateValue_;
+  }
+
+  /**
+   * @brief Delay an update in an internal node without a delayed update.
+   * Children and cached rangeGet result are not touched.
+   */
+  void setPendingUpdate(UpdateT update) {
+    assert(!Base_::isLeaf() && !hasPendingUpdate());
+    updateValue_ = std::move(update);
+  }
 
   ~Node() = default;
 
@@ -75,15 +126,15 @@ class Node<T, std::optional<UpdateT>, Allocator>
 };
 
 ////////////////////////////////////////////////////////////////////////////////
-template <class T, class UpdateT, class Allocator>
-Node<T, std::optional<UpdateT>, Allocator>::Node(const Node& node,
-                                                 Allocator_& allocator)
+template <class T, class UpdateT, class Allocator, class GetCacheT>
+Node<T, std::optional<UpdateT>, Allocator, GetCacheT>::Node(
+    const Node& node, Allocator_& allocator)
     : Base_(node, allocator), updateValue_(node.updateValue_) {
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-template <class T, class UpdateT, class Allocator>
-auto Node<T, std::optional<UpdateT>, Allocator>::assign(
+template <class T, class UpdateT, class Allocator, class GetCacheT>
+auto Node<T, std::optional<UpdateT>, Allocator, GetCacheT>::assign(
     const This_& other, Allocator_& allocator) -> This_& {
   assert(&other != this && "Node must not be assigned to itself.");
   updateValue_ = other.updateValue_;
@@ -92,8 +143,8 @@ auto Node<T, std::optional<UpdateT>, Allocator>::assign(
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-template <class T, class UpdateT, class Allocator>
-auto Node<T, std::optional<UpdateT>, Allocator>::operator=(
+template <class T, class UpdateT, class Allocator, class GetCacheT>
+auto Node<T, std::optional<UpdateT>, Allocator, GetCacheT>::operator=(
     This_&& other) noexcept -> This_& {
   assert(&other != this && "Node must not be assigned to itself.");
   std::swap(updateValue_, other.updateValue_);
@@ -102,30 +153,47 @@ auto Node<T, std::optional<UpdateT>, Allocator>::operator=(
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-template <class T, class UpdateT, class Allocator>
+template <class T, class UpdateT, class Allocator, class GetCacheT>
 template <class ValueT>
   requires std::is_same_v<std::remove_cvref_t<ValueT>, T>
-void Node<T, std::optional<UpdateT>, Allocator>::setValue(
+void Node<T, std::optional<UpdateT>, Allocator, GetCacheT>::setValue(
     ValueT&& value, Allocator_& allocator) {
   Base_::setValue_(std::forward<ValueT>(value), allocator);
   updateValue_.reset();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-template <class T, class UpdateT, class Allocator>
-template <class UpdateOp, class UpdateT1>
+template <class T, class UpdateT, class Allocator, class GetCacheT>
+template <class UpdateOp, class UpdateT1, class UpdateCompose,
+          class CacheUpdate>
   requires std::is_same_v<std::remove_cvref_t<UpdateT1>, UpdateT>
-void Node<T, std::optional<UpdateT>, Allocator>::update(
-    const UpdateOp& updateOp, UpdateT1&& updateVal, Allocator_& allocator) {
+void Node<T, std::optional<UpdateT>, Allocator, GetCacheT>::update(
+    const UpdateOp& updateOp, UpdateT1&& updateVal, Allocator_& allocator,
+    const UpdateCompose& updateCompose, const CacheUpdate& cacheUpdate) {
   if (!Base_::isLeaf()) {
-    if (updateValue_.has_value()) {
-      // update left with old update
-      Base_::getLeft()->update(updateOp, *updateValue_, allocator);
-      // update right with old update
-      Base_::getRight()->update(updateOp, std::move(*updateValue_), allocator);
+    // Cached result includes the node own delayed update.
+    Base_::updateCachedGet_(cacheUpdate, std::as_const(updateVal));
+    if constexpr (std::is_same_v<UpdateCompose, NoUpdateCompose>) {
+      if (updateValue_.has_value()) {
+        // update left with old update
+        Base_::getLeft()->update(updateOp, *updateValue_, allocator,
+                                 updateCompose, cacheUpdate.left());
+        // update right with old update
+        Base_::getRight()->update(updateOp, std::move(*updateValue_),
+                                  allocator, updateCompose,
+                                  cacheUpdate.right());
+      }
+      // _value continues to have delayed update meaning.
+      updateValue_ = std::forward<UpdateT1>(updateVal);
+    } else {
+      if (updateValue_.has_value()) {
+        // Old and new updates are merged without touching children.
+        updateValue_ = updateCompose(std::move(*updateValue_),
+                                     std::forward<UpdateT1>(updateVal));
+      } else {
+        updateValue_ = std::forward<UpdateT1>(updateVal);
+      }
     }
-    // _value continues to have delayed update meaning.
-    updateValue_ = std::forward<UpdateT1>(updateVal);
   } else {  // isLeaf()
     assert(Base_::hasValue() && "Leaf must have a value.");
     assert(!updateValue_.has_value());
@@ -136,23 +204,27 @@ void Node<T, std::optional<UpdateT>, Allocator>::update(
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-template <class T, class UpdateT, class Allocator>
-template <class UpdateOp>
-void Node<T, std::optional<UpdateT>, Allocator>::siftOptUpdate(
-    const UpdateOp& updateOp, Allocator_& allocator) {
+template <class T, class UpdateT, class Allocator, class GetCacheT>
+template <class UpdateOp, class UpdateCompose, class CacheUpdate>
+void Node<T, std::optional<UpdateT>, Allocator, GetCacheT>::siftOptUpdate(
+    const UpdateOp& updateOp, Allocator_& allocator,
+    const UpdateCompose& updateCompose, const CacheUpdate& cacheUpdate) {
   if (updateValue_.has_value()) {
     assert(!Base_::isLeaf() && "It must not be a leaf.");
-    Base_::getLeft()->update(updateOp, *updateValue_, allocator);
-    Base_::getRight()->update(updateOp, std::move(*updateValue_), allocator);
+    Base_::getLeft()->update(updateOp, *updateValue_, allocator,
+                             updateCompose, cacheUpdate.left());
+    Base_::getRight()->update(updateOp, std::move(*updateValue_), allocator,
+                              updateCompose, cacheUpdate.right());
     updateValue_.reset();
   }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-template <class T, class Allocator>
-class Node<T, bool, Allocator> : public BaseNode<Node<T, bool, Allocator>> {
+template <class T, class Allocator, class GetCacheT>
+class Node<T, bool, Allocator, GetCacheT>
+    : public BaseNode<Node<T, bool, Allocator, GetCacheT>> {
  private:
-  using This_ = Node<T, bool, Allocator>;
+  using This_ = Node<T, bool, Allocator, GetCacheT>;
   using Base_ = BaseNode<This_>;
   using Allocator_ =
       std::allocator_traits<Allocator>::template rebind_alloc<This_>;
@@ -169,6 +241,9 @@ class Node<T, bool, Allocator> : public BaseNode<Node<T, bool, Allocator>> {
   Node(const Node& node, Allocator_ allocator)
       : Base_(node, allocator), toUpdate_{node.toUpdate_} {
   }
+  Node(const Node& node, ShallowCopyTag tag)
+      : Base_(node, tag), toUpdate_{node.toUpdate_} {
+  }
   Node(Node&& other) noexcept = default;
   Node& operator=(const Node& other) = delete;
   Node& assign(const Node& other, Allocator_& allocator);
@@ -183,10 +258,35 @@ class Node<T, bool, Allocator> : public BaseNode<Node<T, bool, Allocator>> {
     requires std::is_same_v<std::remove_cvref_t<ValueT>, T>
   void setValue(ValueT&& value, Allocator_& allocator);
 
-  template <class UpdateOp>
-  void update(const UpdateOp& updateOp, Allocator_& allocator);
-  template <class UpdateOp>
-  void siftOptUpdate(const UpdateOp& updateOp, Allocator_& allocator);
+  /**
+   * @brief Apply update to a leaf or delay it in an internal node. Pending
+   * involution updates cancel each other, pending idempotent ones absorb
+   * a new one (see upd::IsInvolution and upd::IsIdempotent).
+   *
+   * @param updateOp update operation.
+   * @param allocator nodes allocator.
+   * @param cacheUpdate update of cached rangeGet result of the node segment
+   * (see NoCacheUpdate).
+   */
+  template <class UpdateOp, class CacheUpdate = NoCacheUpdate>
+  void update(const UpdateOp& updateOp, Allocator_& allocator,
+              const CacheUpdate& cacheUpdate = CacheUpdate{});
+  template <class UpdateOp, class CacheUpdate = NoCacheUpdate>
+  void siftOptUpdate(const UpdateOp& updateOp, Allocator_& allocator,
+                     const CacheUpdate& cacheUpdate = CacheUpdate{});
+
+  [[nodiscard]] bool hasPendingUpdate() const {
+    return toUpdate_;
+  }
+
+  /**
+   * @brief Delay an update in an internal node without a delayed update.
+   * Children and cached rangeGet result are not touched.
+   */
+  void setPendingUpdate() {
+    assert(!Base_::isLeaf() && !hasPendingUpdate());
+    toUpdate_ = true;
+  }
 
   ~Node() = default;
 
@@ -198,44 +298,49 @@ class Node<T, bool, Allocator> : public BaseNode<Node<T, bool, Allocator>> {
 };
 
 ////////////////////////////////////////////////////////////////////////////////
-template <class T, class Allocator>
-auto Node<T, bool, Allocator>::assign(const Node& other,
-                                      Allocator_& allocator) -> This_& {
+template <class T, class Allocator, class GetCacheT>
+auto Node<T, bool, Allocator, GetCacheT>::assign(const Node& other,
+                                                 Allocator_& allocator)
+    -> This_& {
   assert(&other != this && "Node must not be assigned to itself.");
   toUpdate_ = other.toUpdate_;
   return static_cast<This_&>(Base_::assign(other, allocator));
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-template <class T, class Allocator>
-auto Node<T, bool, Allocator>::operator=(Node&& other) noexcept -> This_& {
+template <class T, class Allocator, class GetCacheT>
+auto Node<T, bool, Allocator, GetCacheT>::operator=(Node&& other) noexcept
+    -> This_& {
   assert(&other != this && "Node must not be assigned to itself.");
   std::swap(toUpdate_, other.toUpdate_);
   return static_cast<This_&>(Base_::operator=(std::move(other)));  // NOLINT
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-template <class T, class Allocator>
+template <class T, class Allocator, class GetCacheT>
 template <class ValueT>
   requires std::is_same_v<std::remove_cvref_t<ValueT>, T>
-void Node<T, bool, Allocator>::setValue(ValueT&& value, Allocator_& allocator) {
+void Node<T, bool, Allocator, GetCacheT>::setValue(ValueT&& value,
+                                                   Allocator_& allocator) {
   Base_::setValue_(std::forward<ValueT>(value), allocator);
   toUpdate_ = false;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-template <class T, class Allocator>
-template <class UpdateOp>
-void Node<T, bool, Allocator>::update(const UpdateOp& updateOp,
-                                      Allocator_& allocator) {
+template <class T, class Allocator, class GetCacheT>
+template <class UpdateOp, class CacheUpdate>
+void Node<T, bool, Allocator, GetCacheT>::update(
+    const UpdateOp& updateOp, Allocator_& allocator,
+    const CacheUpdate& cacheUpdate) {
   if (!Base_::isLeaf()) {
-    if (toUpdate_) {
-      Base_::getLeft()->update(updateOp,
-                               allocator);  // update left with old update
-      Base_::getRight()->update(updateOp,
-                                allocator);  // update right with old update
+    const bool changed = addPendingFlag<UpdateOp>(toUpdate_, [&] {
+      // update children with old update
+      Base_::getLeft()->update(updateOp, allocator, cacheUpdate.left());
+      Base_::getRight()->update(updateOp, allocator, cacheUpdate.right());
+    });
+    if (changed) {
+      Base_::updateCachedGet_(cacheUpdate);
     }
-    toUpdate_ = true;
   } else {  // isLeaf()
     assert(Base_::hasValue());
     assert(!toUpdate_);
@@ -244,23 +349,25 @@ void Node<T, bool, Allocator>::update(const UpdateOp& updateOp,
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-template <class T, class Allocator>
-template <class UpdateOp>
-void Node<T, bool, Allocator>::siftOptUpdate(const UpdateOp& updateOp,
-                                             Allocator_& allocator) {
+template <class T, class Allocator, class GetCacheT>
+template <class UpdateOp, class CacheUpdate>
+void Node<T, bool, Allocator, GetCacheT>::siftOptUpdate(
+    const UpdateOp& updateOp, Allocator_& allocator,
+    const CacheUpdate& cacheUpdate) {
   if (toUpdate_) {
     assert(!Base_::isLeaf() && "It must not be a leaf.");
-    Base_::getLeft()->update(updateOp, allocator);
-    Base_::getRight()->update(updateOp, allocator);
+    Base_::getLeft()->update(updateOp, allocator, cacheUpdate.left());
+    Base_::getRight()->update(updateOp, allocator, cacheUpdate.right());
     toUpdate_ = false;
   }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-template <class T, class Allocator>
-class Node<T, void, Allocator> : public BaseNode<Node<T, void, Allocator>> {
+template <class T, class Allocator, class GetCacheT>
+class Node<T, void, Allocator, GetCacheT>
+    : public BaseNode<Node<T, void, Allocator, GetCacheT>> {
  private:
-  using This_ = Node<T, void, Allocator>;
+  using This_ = Node<T, void, Allocator, GetCacheT>;
   using Base_ = BaseNode<This_>;
   using Allocator_ =
       std::allocator_traits<Allocator>::template rebind_alloc<This_>;
@@ -279,6 +386,9 @@ class Node<T, void, Allocator> : public BaseNode<Node<T, void, Allocator>> {
   Node(const Node& other, Allocator_& allocator) : Base_(other, allocator) {
   }
 
+  Node(const Node& other, ShallowCopyTag tag) : Base_(other, tag) {
+  }
+
   Node(Node&& other) noexcept = default;
 
   Node& operator=(const Node& other) = delete;
@@ -303,24 +413,27 @@ class Node<T, void, Allocator> : public BaseNode<Node<T, void, Allocator>> {
 };
 
 ////////////////////////////////////////////////////////////////////////////////
-template <class T, class Allocator>
-auto Node<T, void, Allocator>::assign(const This_& other,
-                                      Allocator_& allocator) -> This_& {
+template <class T, class Allocator, class GetCacheT>
+auto Node<T, void, Allocator, GetCacheT>::assign(const This_& other,
+                                                 Allocator_& allocator)
+    -> This_& {
   assert(&other != this && "Node must not be assigned to itself.");
   return static_cast<This_&>(Base_::assign(other, allocator));
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-template <class T, class Allocator>
-auto Node<T, void, Allocator>::operator=(This_&& other) noexcept -> This_& {
+template <class T, class Allocator, class GetCacheT>
+auto Node<T, void, Allocator, GetCacheT>::operator=(This_&& other) noexcept
+    -> This_& {
   return static_cast<This_&>(Base_::operator=(std::move(other)));  // NOLINT
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-template <class T, class Allocator>
+template <class T, class Allocator, class GetCacheT>
 template <class ValueT>
   requires std::is_same_v<std::remove_cvref_t<ValueT>, T>
-void Node<T, void, Allocator>::setValue(ValueT&& value, Allocator_& allocator) {
+void Node<T, void, Allocator, GetCacheT>::setValue(ValueT&& value,
+                                                   Allocator_& allocator) {
   Base_::setValue_(std::forward<ValueT>(value), allocator);
 }
 
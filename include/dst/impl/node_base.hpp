@@ -7,12 +7,69 @@
 #ifndef NODE_BASE_HPP
 #define NODE_BASE_HPP
 
+#include <array>
+#include <cassert>
 #include <concepts>
+#include <cstddef>
 #include <memory>
 #include <optional>
+#include <type_traits>
+#include <utility>
 
 namespace dst::impl {
 
+////////////////////////////////////////////////////////////////////////////////
+/// \brief The OptNodeGetCache class. Storage of a cached rangeGet result.
+///
+/// \tparam GetCacheT cached value type or void if there is no cache.
+///
+template <class GetCacheT>
+struct OptNodeGetCache {
+  using Type = std::optional<GetCacheT>;
+};
+
+template <>
+struct OptNodeGetCache<void> {
+  struct Type {};
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief The NodeValue class. Storage of a leaf value.
+///
+/// \tparam T value type.
+///
+/// Trivially copyable values are stored without an engaged flag, as a node
+/// is a leaf (and has a value) exactly when it has no children. For example,
+/// it makes a node of an int64_t tree without update operation 16 bytes.
+///
+template <class T>
+struct NodeValue {
+  using Type = std::optional<T>;
+};
+
+template <class T>
+  requires std::is_trivially_copyable_v<T> && std::is_default_constructible_v<T>
+struct NodeValue<T> {
+  using Type = T;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Tag of a node copy constructor, which does not copy children.
+struct ShallowCopyTag {};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Cached rangeGet results are not updated, updated nodes drop them.
+/// Otherwise an operation, which applies an update to a cached result of a
+/// segment, and gives the ones of its halves by left() and right().
+struct NoCacheUpdate {
+  [[nodiscard]] NoCacheUpdate left() const {
+    return {};
+  }
+  [[nodiscard]] NoCacheUpdate right() const {
+    return {};
+  }
+};
+
 template <class Derived>
 class BaseNode;
 
@@ -20,14 +77,22 @@ class BaseNode;
 /// \brief The BaseNode class
 ///
 template <template <class...> class Derived, class T, class UpdateT,
-          class Allocator>
-class BaseNode<Derived<T, UpdateT, Allocator>> {
+          class Allocator, class GetCacheT>
+class BaseNode<Derived<T, UpdateT, Allocator, GetCacheT>> {
  protected:
-  using This_ = BaseNode<Derived<T, UpdateT, Allocator>>;
-  using Derived_ = Derived<T, UpdateT, Allocator>;
+  using This_ = BaseNode<Derived<T, UpdateT, Allocator, GetCacheT>>;
+  using Derived_ = Derived<T, UpdateT, Allocator, GetCacheT>;
   using AllocatorForDerived_ =
       std::allocator_traits<Allocator>::template rebind_alloc<Derived_>;
   using AllocatorTraits_ = std::allocator_traits<AllocatorForDerived_>;
+  using GetCache_ = OptNodeGetCache<GetCacheT>::Type;
+  using Value_ = NodeValue<T>::Type;
+
+  constexpr static bool kHasGetCache_ = !std::is_void_v<GetCacheT>;
+  constexpr static bool kPlainValue_ = std::is_same_v<Value_, T>;
+  // Subtrees are walked with an explicit stack. A tree is never deeper than
+  // the number of key bits, deeper parts are handled by recursion.
+  constexpr static std::size_t kStackSize_ = 128;
 
  public:
   explicit BaseNode(const T& value) : value_(value) {
@@ -41,8 +106,14 @@ class BaseNode<Derived<T, UpdateT, Allocator>> {
 
   BaseNode(const BaseNode& other, AllocatorForDerived_& allocator);
 
+  BaseNode(const BaseNode& other, ShallowCopyTag)
+      : value_(other.value_), getCache_(other.getCache_) {
+  }
+
   BaseNode(BaseNode&& other) noexcept
-      : value_(std::move(other.value_)), ptr_{other.ptr_} {
+      : value_(std::move(other.value_)),
+        getCache_(std::move(other.getCache_)),
+        ptr_{other.ptr_} {
     other.ptr_ = nullptr;
   }
 
@@ -78,11 +149,19 @@ class BaseNode<Derived<T, UpdateT, Allocator>> {
    */
   [[nodiscard]] const T& getValue() const {
     assert(hasValue());
-    return *value_;
+    if constexpr (kPlainValue_) {
+      return value_;
+    } else {
+      return *value_;
+    }
   }
 
   [[nodiscard]] bool hasValue() const {
-    return value_.has_value();
+    if constexpr (kPlainValue_) {
+      return isLeaf();
+    } else {
+      return value_.has_value();
+    }
   }
 
   [[nodiscard]] bool isLeaf() const {
@@ -95,6 +174,24 @@ class BaseNode<Derived<T, UpdateT, Allocator>> {
   template <class AllocatorForDerived>
   void clearChildren(AllocatorForDerived& allocator);
 
+  /**
+   * @brief Forget children without destroying them. Used when their memory
+   * was released in bulk by an allocator.
+   */
+  void abandonChildren() {
+    ptr_ = nullptr;
+    resetCachedGet();
+  }
+
+  /**
+   * @brief Turn a node with two leaf children into a leaf, taking the value of
+   * the left child. Node must not have a delayed update.
+   *
+   * @param allocator allocator for children.
+   */
+  template <class AllocatorForDerived>
+  void coalesceChildren(AllocatorForDerived& allocator);
+
   [[nodiscard]] Derived_* getLeft() const {
     return ptr_;
   }
@@ -103,6 +200,41 @@ class BaseNode<Derived<T, UpdateT, Allocator>> {
     return ptr_ + 1;  // NOLINT
   }
 
+  /**
+   * @brief Check if an internal node has a valid cached rangeGet result.
+   */
+  [[nodiscard]] bool hasCachedGet() const {
+    return getCache_.has_value();
+  }
+
+  /**
+   * @brief Get cached rangeGet result of a whole node segment.
+   * @return cached result reference.
+   */
+  [[nodiscard]] const auto& getCachedGet() const {
+    assert(hasCachedGet());
+    return *getCache_;
+  }
+
+  /**
+   * @brief Store rangeGet result of a whole node segment.
+   * @param getValue result to store.
+   */
+  template <class GetValueT>
+  void setCachedGet(GetValueT&& getValue) {
+    assert(!isLeaf() && "Only internal nodes store rangeGet results.");
+    getCache_ = std::forward<GetValueT>(getValue);
+  }
+
+  /**
+   * @brief Mark cached rangeGet result as outdated.
+   */
+  void resetCachedGet() {
+    if constexpr (kHasGetCache_) {
+      getCache_.reset();
+    }
+  }
+
  protected:
   /**
    * @brief Set value to node making a copy.
@@ -112,126 +244,231 @@ class BaseNode<Derived<T, UpdateT, Allocator>> {
     requires std::is_same_v<std::remove_cvref_t<ValueT>, T>
   void setValue_(ValueT&&, AllocatorForDerived& allocator);
 
+  /**
+   * @brief Apply an update to cached rangeGet result of an internal node.
+   *
+   * @param cacheUpdate operation on cached result or NoCacheUpdate, then the
+   * result is dropped.
+   * @param args update operation arguments.
+   */
+  template <class CacheUpdate, class... UpdateArgs>
+  void updateCachedGet_(const CacheUpdate& cacheUpdate,
+                        const UpdateArgs&... args) {
+    if constexpr (kHasGetCache_) {
+      if constexpr (std::is_same_v<CacheUpdate, NoCacheUpdate>) {
+        getCache_.reset();
+      } else if (getCache_.has_value()) {
+        getCache_ = cacheUpdate(*getCache_, args...);
+      }
+    }
+  }
+
   ~BaseNode();
 
  private:
-  void destructChildrenRecursive_();
+  template <class AllocForDerived>
+  void copyChildren_(const BaseNode& other, AllocForDerived& allocator);
+
+  T& valueRef_() {
+    if constexpr (kPlainValue_) {
+      return value_;
+    } else {
+      return *value_;
+    }
+  }
 
  private:
-  std::optional<T> value_;
+  Value_ value_{};
+  [[no_unique_address]] GetCache_ getCache_;
   Derived_* ptr_{nullptr};
 };
 
 ////////////////////////////////////////////////////////////////////////////////
 template <template <class...> class Derived, class T, class UpdateT,
-          class Allocator>
-BaseNode<Derived<T, UpdateT, Allocator>>::BaseNode(
+          class Allocator, class GetCacheT>
+BaseNode<Derived<T, UpdateT, Allocator, GetCacheT>>::BaseNode(
     const BaseNode& other, AllocatorForDerived_& allocator)
-    : value_(other.value_),
-      ptr_(other.isLeaf() ? nullptr
-                          : AllocatorTraits_::allocate(allocator, 2)) {
-  if (!isLeaf()) {
-    std::construct_at(getLeft(), *other.getLeft(), allocator);
-    std::construct_at(getRight(), *other.getRight(), allocator);
-  }
+    : value_(other.value_), getCache_(other.getCache_) {
+  copyChildren_(other, allocator);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 template <template <class...> class Derived, class T, class UpdateT,
-          class Allocator>
-auto BaseNode<Derived<T, UpdateT, Allocator>>::assign(
+          class Allocator, class GetCacheT>
+auto BaseNode<Derived<T, UpdateT, Allocator, GetCacheT>>::assign(
     const BaseNode& other, AllocatorForDerived_& allocator) -> This_& {
   assert(&other != this && "Assign operator must not be called on itself.");
-  value_ = other.value_;
   if (nullptr != ptr_) {
     clearChildren(allocator);
   }
-  if (other.isLeaf()) {
-    ptr_ = nullptr;
-  } else {
-    ptr_ = AllocatorTraits_::allocate(allocator, 2);
-    std::construct_at(getLeft(), *other.getLeft(), allocator);
-    std::construct_at(getRight(), *other.getRight(), allocator);
-  }
+  value_ = other.value_;
+  getCache_ = other.getCache_;
+  copyChildren_(other, allocator);
   return *this;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 template <template <class...> class Derived, class T, class UpdateT,
-          class Allocator>
-auto BaseNode<Derived<T, UpdateT, Allocator>>::operator=(
+          class Allocator, class GetCacheT>
+auto BaseNode<Derived<T, UpdateT, Allocator, GetCacheT>>::operator=(
     BaseNode&& other) noexcept -> This_& {
   assert(&other != this && "Assign operator must not be called on itself.");
   std::swap(value_, other.value_);
+  std::swap(getCache_, other.getCache_);
   std::swap(ptr_, other.ptr_);
   return *this;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 template <template <class...> class Derived, class T, class UpdateT,
-          class Allocator>
+          class Allocator, class GetCacheT>
 template <class ValueT, class AllocForDerived>
   requires std::is_same_v<std::remove_cvref_t<ValueT>, T>
-void BaseNode<Derived<T, UpdateT, Allocator>>::setValue_(
+void BaseNode<Derived<T, UpdateT, Allocator, GetCacheT>>::setValue_(
     ValueT&& value, AllocForDerived& allocator) {
   value_ = std::forward<ValueT>(value);
   if (!this->isLeaf()) {
     clearChildren(allocator);
   }
+  resetCachedGet();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 template <template <class...> class Derived, class T, class UpdateT,
-          class Allocator>
+          class Allocator, class GetCacheT>
 template <class AllocForDerived>
-void BaseNode<Derived<T, UpdateT, Allocator>>::initChildren(
+void BaseNode<Derived<T, UpdateT, Allocator, GetCacheT>>::initChildren(
     AllocForDerived& allocator) {
   assert(isLeaf() && "Can only init children for a leaf.");
   auto nodesPtr =
       std::allocator_traits<AllocForDerived>::allocate(allocator, 2);
 
-  assert(value_.has_value() && "No value to set to children.");
+  assert(hasValue() && "No value to set to children.");
   try {
     ptr_ = nodesPtr;
-    std::construct_at(getLeft(), *value_);
+    std::construct_at(getLeft(), std::as_const(valueRef_()));
   } catch (...) {
     std::allocator_traits<AllocForDerived>::deallocate(allocator, ptr_, 2);
     ptr_ = nullptr;
     throw;
   }
   try {
-    std::construct_at(getRight(), std::move(*value_));
+    std::construct_at(getRight(), std::move(valueRef_()));
   } catch (...) {
     getLeft()->~Derived_();
     std::allocator_traits<AllocForDerived>::deallocate(allocator, ptr_, 2);
     ptr_ = nullptr;
     throw;
   }
-  value_.reset();
+  if constexpr (!kPlainValue_) {
+    value_.reset();
+  }
+  resetCachedGet();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 template <template <class...> class Derived, class T, class UpdateT,
-          class Allocator>
+          class Allocator, class GetCacheT>
 template <class AllocForDerived>
-inline void BaseNode<Derived<T, UpdateT, Allocator>>::clearChildren(
+inline void BaseNode<Derived<T, UpdateT, Allocator, GetCacheT>>::clearChildren(
     AllocForDerived& allocator) {
-  if (!getLeft()->isLeaf()) {
-    getLeft()->clearChildren(allocator);
+  using Traits = std::allocator_traits<AllocForDerived>;
+  std::array<Derived_*, kStackSize_> pairs;  // NOLINT
+  std::size_t size = 0;
+  pairs[size++] = std::exchange(ptr_, nullptr);
+  while (size != 0) {
+    Derived_* const pair = pairs[--size];
+    for (BaseNode* child : {static_cast<BaseNode*>(pair),
+                            static_cast<BaseNode*>(pair + 1)}) {  // NOLINT
+      if (child->isLeaf()) {
+        continue;
+      }
+      if (size == kStackSize_) {
+        child->clearChildren(allocator);
+      } else {
+        pairs[size++] = std::exchange(child->ptr_, nullptr);
+      }
+    }
+    Traits::destroy(allocator, pair + 1);  // NOLINT
+    Traits::destroy(allocator, pair);
+    Traits::deallocate(allocator, pair, 2);
   }
-  if (!getRight()->isLeaf()) {
-    getRight()->clearChildren(allocator);
+  resetCachedGet();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <template <class...> class Derived, class T, class UpdateT,
+          class Allocator, class GetCacheT>
+template <class AllocForDerived>
+void BaseNode<Derived<T, UpdateT, Allocator, GetCacheT>>::copyChildren_(
+    const BaseNode& other, AllocForDerived& allocator) {
+  assert(isLeaf() && "Children must be cleared before copy.");
+  using Traits = std::allocator_traits<AllocForDerived>;
+  // Pairs of a copied node and its origin, which children are not copied yet.
+  std::array<std::pair<BaseNode*, const BaseNode*>, kStackSize_> nodes;
+  std::size_t size = 0;
+  if (!other.isLeaf()) {
+    nodes[size++] = {this, &other};
   }
-  std::allocator_traits<AllocForDerived>::destroy(allocator, getRight());
-  std::allocator_traits<AllocForDerived>::destroy(allocator, getLeft());
-  std::allocator_traits<AllocForDerived>::deallocate(allocator, ptr_, 2);
-  ptr_ = nullptr;
+  try {
+    while (size != 0) {
+      const auto [copy, origin] = nodes[--size];
+      Derived_* const pair = Traits::allocate(allocator, 2);
+      try {
+        std::construct_at(pair, *origin->getLeft(), ShallowCopyTag{});
+      } catch (...) {
+        Traits::deallocate(allocator, pair, 2);
+        throw;
+      }
+      try {
+        std::construct_at(pair + 1, *origin->getRight(),  // NOLINT
+                          ShallowCopyTag{});
+      } catch (...) {
+        Traits::destroy(allocator, pair);
+        Traits::deallocate(allocator, pair, 2);
+        throw;
+      }
+      copy->ptr_ = pair;
+      for (const bool right : {false, true}) {
+        BaseNode* const child = right ? copy->getRight() : copy->getLeft();
+        const BaseNode* const childOrigin =
+            right ? origin->getRight() : origin->getLeft();
+        if (childOrigin->isLeaf()) {
+          continue;
+        }
+        if (size == kStackSize_) {
+          child->copyChildren_(*childOrigin, allocator);
+        } else {
+          nodes[size++] = {child, childOrigin};
+        }
+      }
+    }
+  } catch (...) {
+    // Copied part is a valid tree, which leaves are not copied further.
+    if (!isLeaf()) {
+      clearChildren(allocator);
+    }
+    throw;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <template <class...> class Derived, class T, class UpdateT,
+          class Allocator, class GetCacheT>
+template <class AllocForDerived>
+void BaseNode<Derived<T, UpdateT, Allocator, GetCacheT>>::coalesceChildren(
+    AllocForDerived& allocator) {
+  assert(!isLeaf() && "Can only coalesce children of an internal node.");
+  assert(getLeft()->isLeaf() && getRight()->isLeaf() &&
+         "Both children must be leaves.");
+  value_ = std::move(getLeft()->value_);
+  clearChildren(allocator);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 template <template <class...> class Derived, class T, class UpdateT,
-          class Allocator>
-BaseNode<Derived<T, UpdateT, Allocator>>::~BaseNode() {
+          class Allocator, class GetCacheT>
+BaseNode<Derived<T, UpdateT, Allocator, GetCacheT>>::~BaseNode() {
   assert(isLeaf());
 }
 
@@ -0,0 +1,241 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright Georgy Guminov 2023-2024.
+// Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt
+// or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef PENDING_HPP
+#define PENDING_HPP
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <dst/concepts.hpp>
+#include <dst/disable_operations.hpp>
+#include <dst/upd.hpp>
+#include <limits>
+#include <optional>
+#include <type_traits>
+
+namespace dst::impl {
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief The NodePending<UpdateOp, ValueT, UpdateArgT> class.
+///
+/// NodePending::Type is a delayed update stored in a node:
+/// std::optional<UpdateArgT> for two arguments update operation, bool for one
+/// argument update operation and an empty struct if update is turned off.
+///
+template <class UpdateOp, class ValueT, class UpdateArgT>
+struct NodePending {
+  using Type = std::optional<UpdateArgT>;
+};
+
+template <class UpdateOp, class ValueT, class UpdateArgT>
+  requires conc::OneArgUpdateOp<UpdateOp, ValueT>
+struct NodePending<UpdateOp, ValueT, UpdateArgT> {
+  using Type = bool;
+};
+
+template <class ValueT, class UpdateArgT>
+struct NodePending<NoUpdateOp, ValueT, UpdateArgT> {
+  struct Type {};
+};
+
+/**
+ * @brief Check if a delayed update is stored.
+ *
+ * @param pending delayed update of a node.
+ * @return true if there is a delayed update.
+ */
+template <class PendingT>
+constexpr bool isPending(const PendingT& pending) {
+  if constexpr (std::is_same_v<PendingT, bool>) {
+    return pending;
+  } else if constexpr (std::is_empty_v<PendingT>) {
+    return false;
+  } else {
+    return pending.has_value();
+  }
+}
+
+/**
+ * @brief Add a one argument update to a delayed update flag of an internal
+ * node. Involution updates cancel each other and a delayed idempotent update
+ * absorbs the new one. Otherwise the delayed update is pushed down to
+ * children by `sift` first.
+ *
+ * @param pending delayed update flag.
+ * @param sift pushes the delayed update down to children.
+ * @return false if the new update is absorbed and nothing is changed.
+ */
+template <class UpdateOp, class Sift>
+bool addPendingFlag(bool& pending, const Sift& sift) {
+  if constexpr (upd::kIsInvolution<UpdateOp>) {
+    pending = !pending;
+    return true;
+  } else {
+    if (pending) {
+      if constexpr (upd::kIsIdempotent<UpdateOp>) {
+        return false;
+      }
+      sift();
+    }
+    pending = true;
+    return true;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief The PendingPath<UpdateOp, ValueT, UpdateArgT, KeyT> class. Delayed
+/// updates met on the way from the root down to a node. The deepest one is
+/// the oldest. A path is never longer than the number of KeyT bits, so no
+/// allocation is needed.
+///
+/// Nodes are pushed and popped with `hasPendingUpdate()` and
+/// `getPendingUpdate()`. A node must not change between its push and pop.
+///
+template <class UpdateOp, class ValueT, class UpdateArgT, class KeyT>
+class PendingPath {
+ public:
+  template <class NodeT>
+  void push(const NodeT& node) {
+    if (node.hasPendingUpdate()) {
+      assert(size_ < updates_.size() && "Path is too long.");
+      updates_[size_++] = &node.getPendingUpdate();
+    }
+  }
+
+  template <class NodeT>
+  void pop(const NodeT& node) {
+    if (node.hasPendingUpdate()) {
+      --size_;
+    }
+  }
+
+  [[nodiscard]] bool empty() const {
+    return size_ == 0;
+  }
+
+  /**
+   * @brief Calculate a value as if all delayed updates of a path were pushed
+   * down to it.
+   */
+  ValueT apply(const UpdateOp& updateOp, const ValueT& value) const {
+    ValueT ret = value;
+    for (std::size_t i = size_; i > 0; --i) {
+      ret = updateOp(ret, *updates_[i - 1]);
+    }
+    return ret;
+  }
+
+  /**
+   * @brief Calculate a cached rangeGet result of a segment as if all delayed
+   * updates of a path were pushed down to it.
+   */
+  template <class CacheUpdateOp, class CacheT>
+  CacheT applyToGet(const CacheUpdateOp& cacheUpdateOp, const CacheT& cached,
+                    KeyT begin, KeyT end) const {
+    CacheT ret = cached;
+    for (std::size_t i = size_; i > 0; --i) {
+      ret = cacheUpdateOp(ret, *updates_[i - 1], begin, end);
+    }
+    return ret;
+  }
+
+ private:
+  std::array<const UpdateArgT*,
+             std::numeric_limits<std::make_unsigned_t<KeyT>>::digits>
+      updates_;
+  std::size_t size_{0};
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Path of one argument delayed updates. Only their number matters.
+template <class UpdateOp, class ValueT, class UpdateArgT, class KeyT>
+  requires conc::OneArgUpdateOp<UpdateOp, ValueT>
+class PendingPath<UpdateOp, ValueT, UpdateArgT, KeyT> {
+ public:
+  template <class NodeT>
+  void push(const NodeT& node) {
+    count_ += node.hasPendingUpdate() ? 1 : 0;
+  }
+
+  template <class NodeT>
+  void pop(const NodeT& node) {
+    count_ -= node.hasPendingUpdate() ? 1 : 0;
+  }
+
+  [[nodiscard]] bool empty() const {
+    return count_ == 0;
+  }
+
+  ValueT apply(const UpdateOp& updateOp, const ValueT& value) const {
+    ValueT ret = value;
+    for (std::size_t count = effectiveCount_(); count > 0; --count) {
+      ret = updateOp(ret);
+    }
+    return ret;
+  }
+
+  template <class CacheUpdateOp, class CacheT>
+  CacheT applyToGet(const CacheUpdateOp& cacheUpdateOp, const CacheT& cached,
+                    KeyT begin, KeyT end) const {
+    CacheT ret = cached;
+    for (std::size_t count = effectiveCount_(); count > 0; --count) {
+      ret = cacheUpdateOp(ret, begin, end);
+    }
+    return ret;
+  }
+
+ private:
+  // Number of updates, which have an effect: pending involution updates
+  // cancel each other, pending idempotent ones act as one.
+  [[nodiscard]] std::size_t effectiveCount_() const {
+    if constexpr (upd::kIsInvolution<UpdateOp>) {
+      return count_ % 2;
+    } else if constexpr (upd::kIsIdempotent<UpdateOp>) {
+      return std::min<std::size_t>(count_, 1);
+    } else {
+      return count_;
+    }
+  }
+
+ private:
+  std::size_t count_{0};
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Path of a tree without update operation. It is always empty.
+template <class ValueT, class UpdateArgT, class KeyT>
+class PendingPath<NoUpdateOp, ValueT, UpdateArgT, KeyT> {
+ public:
+  template <class NodeT>
+  void push(const NodeT& /*node*/) {
+  }
+
+  template <class NodeT>
+  void pop(const NodeT& /*node*/) {
+  }
+
+  [[nodiscard]] bool empty() const {
+    return true;
+  }
+
+  const ValueT& apply(const NoUpdateOp& /*updateOp*/,
+                      const ValueT& value) const {
+    return value;
+  }
+
+  template <class CacheUpdateOp, class CacheT>
+  const CacheT& applyToGet(const CacheUpdateOp& /*cacheUpdateOp*/,
+                           const CacheT& cached, KeyT /*begin*/,
+                           KeyT /*end*/) const {
+    return cached;
+  }
+};
+
+}  // namespace dst::impl
+
+#endif  // PENDING_HPP
@@ -0,0 +1,70 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright Georgy Guminov 2023-2024.
+// Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt
+// or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef KEY_RANGE_HPP
+#define KEY_RANGE_HPP
+
+#include <concepts>
+#include <limits>
+#include <type_traits>
+
+namespace dst {
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Tag of a constructor, which makes a tree over all keys of its key
+/// type. The end of a working area is not included, so the maximal key is
+/// kept out of the root segment [min, max). Ranges, which end with the minimal
+/// key, wrap past the maximal key and include it.
+struct FullKeyRange {};
+
+constexpr inline auto kFullKeyRange = FullKeyRange{};
+
+namespace impl {
+
+/**
+ * @brief Separation point of a segment [begin, end). Same as
+ * `(begin + end) / 2`, but without overflow on any pair of keys, so trees
+ * built by different versions have the same shape.
+ *
+ * @param begin segment beginning.
+ * @param end segment ending.
+ * @return separation point.
+ */
+template <std::integral KeyT>
+constexpr KeyT midpoint(KeyT begin, KeyT end) noexcept {
+  using UKeyT = std::make_unsigned_t<KeyT>;
+  const auto floor = static_cast<KeyT>(
+      static_cast<UKeyT>(begin) +
+      static_cast<UKeyT>(static_cast<UKeyT>(end) - static_cast<UKeyT>(begin)) /
+          2);
+  if constexpr (std::is_signed_v<KeyT>) {
+    // Division rounds toward zero. Odd negative sums are rounded up.
+    return static_cast<KeyT>(floor + (floor < 0 && ((begin ^ end) & 1) != 0));
+  } else {
+    return floor;
+  }
+}
+
+/**
+ * @brief Number of keys in a segment [begin, end) without overflow.
+ *
+ * @param begin segment beginning.
+ * @param end segment ending.
+ * @return segment length.
+ */
+template <std::integral KeyT>
+constexpr std::make_unsigned_t<KeyT> keyDistance(KeyT begin,
+                                                 KeyT end) noexcept {
+  using UKeyT = std::make_unsigned_t<KeyT>;
+  return static_cast<UKeyT>(static_cast<UKeyT>(end) -
+                            static_cast<UKeyT>(begin));
+}
+
+}  // namespace impl
+
+}  // namespace dst
+
+#endif  // KEY_RANGE_HPP
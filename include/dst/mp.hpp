@@ -9,6 +9,7 @@
 
 #include <dst/concepts.hpp>
 #include <dst/disable_operations.hpp>
+#include <dst/policies.hpp>
 
 namespace dst::mp {
 
@@ -43,6 +44,58 @@ struct DefaultUpdateArg<NoUpdateOp, ValueT> {
 template <class UpdateOp, class ValueT>
 using DefaultUpdateArgT = mp::DefaultUpdateArg<UpdateOp, ValueT>::Type;
 
+////////////////////////////////////////////////////////////////////////////////
+/// \brief The NodeGetCache<RangeGetCachePolicy, GetValueT> class.
+///
+/// \tparam RangeGetCachePolicy NoRangeGetCache, RangeGetCache or
+/// RangeGetCacheWithUpdate.
+/// \tparam GetValueT rangeGet operation result type.
+///
+/// NodeGetCache::Type is a type stored in internal nodes as a cached rangeGet
+/// result. It is void if caching is turned off.
+///
+template <class RangeGetCachePolicy, class GetValueT>
+struct NodeGetCache {
+  using Type = void;
+};
+
+template <class GetValueT>
+struct NodeGetCache<RangeGetCache, GetValueT> {
+  using Type = GetValueT;
+};
+
+template <class CacheUpdateOp, class GetValueT>
+struct NodeGetCache<RangeGetCacheWithUpdate<CacheUpdateOp>, GetValueT> {
+  using Type = GetValueT;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Type of a cached rangeGet result stored in nodes.
+template <class RangeGetCachePolicy, class GetValueT>
+using NodeGetCacheT =
+    mp::NodeGetCache<RangeGetCachePolicy, GetValueT>::Type;
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief The CacheUpdate<RangeGetCachePolicy> class.
+///
+/// CacheUpdate::Type is an operation, which applies an update to a cached
+/// rangeGet result. It is NoUpdateOp if cached results are not updated.
+///
+template <class RangeGetCachePolicy>
+struct CacheUpdate {
+  using Type = NoUpdateOp;
+};
+
+template <class CacheUpdateOp>
+struct CacheUpdate<RangeGetCacheWithUpdate<CacheUpdateOp>> {
+  using Type = CacheUpdateOp;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Operation, which applies an update to a cached rangeGet result.
+template <class RangeGetCachePolicy>
+using CacheUpdateT = mp::CacheUpdate<RangeGetCachePolicy>::Type;
+
 }  // namespace dst::mp
 
 #endif  // MPIMPL_HPP
@@ -0,0 +1,202 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright Georgy Guminov 2023-2024.
+// Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt
+// or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef NODE_ARENA_HPP
+#define NODE_ARENA_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace dst {
+
+namespace impl {
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief The NodeArenaResource class. Memory shared by all copies of one
+/// NodeArena.
+///
+/// Slot size is fixed by the first allocation. Slots are carved out of
+/// chunks and returned to a free list on deallocation. Allocations of other
+/// sizes go directly to operator new.
+///
+class NodeArenaResource {
+ public:
+  constexpr static std::size_t kSlotsPerChunk = 512;
+
+ public:
+  NodeArenaResource() = default;
+  NodeArenaResource(const NodeArenaResource&) = delete;
+  NodeArenaResource(NodeArenaResource&&) = delete;
+  NodeArenaResource& operator=(const NodeArenaResource&) = delete;
+  NodeArenaResource& operator=(NodeArenaResource&&) = delete;
+
+  void* allocate(std::size_t size, std::size_t alignment);
+
+  void deallocate(void* ptr, std::size_t size, std::size_t alignment) noexcept;
+
+  /**
+   * @brief Release all chunks at once. All slots become invalid.
+   */
+  void clear() noexcept;
+
+  [[nodiscard]] std::size_t chunksCount() const {
+    return chunks_.size();
+  }
+
+  ~NodeArenaResource() {
+    clear();
+  }
+
+ private:
+  struct FreeSlot_ {
+    FreeSlot_* next;
+  };
+
+ private:
+  [[nodiscard]] bool isSlotSized_(std::size_t size,
+                                  std::size_t alignment) const {
+    return std::max(size, sizeof(FreeSlot_)) <= slotSize_ &&
+           std::max(alignment, alignof(FreeSlot_)) == slotAlign_;
+  }
+
+ private:
+  std::vector<std::byte*> chunks_;
+  FreeSlot_* freeList_{nullptr};
+  std::byte* chunkCurr_{nullptr};
+  std::byte* chunkEnd_{nullptr};
+  std::size_t slotSize_{0};
+  std::size_t slotAlign_{0};
+};
+
+////////////////////////////////////////////////////////////////////////////////
+inline void* NodeArenaResource::allocate(std::size_t size,
+                                         std::size_t alignment) {
+  if (slotSize_ == 0) {
+    slotAlign_ = std::max(alignment, alignof(FreeSlot_));
+    slotSize_ = (std::max(size, sizeof(FreeSlot_)) + slotAlign_ - 1) /
+                slotAlign_ * slotAlign_;
+  }
+  if (!isSlotSized_(size, alignment)) {
+    return ::operator new(size, std::align_val_t{alignment});
+  }
+  if (freeList_ != nullptr) {
+    return std::exchange(freeList_, freeList_->next);
+  }
+  if (chunkCurr_ == chunkEnd_) {
+    if (chunks_.size() == chunks_.capacity()) {
+      // Reserved before a chunk is allocated, so push_back can not throw.
+      chunks_.reserve(2 * chunks_.size() + 1);
+    }
+    chunkCurr_ = static_cast<std::byte*>(::operator new(
+        slotSize_ * kSlotsPerChunk, std::align_val_t{slotAlign_}));
+    chunkEnd_ = chunkCurr_ + slotSize_ * kSlotsPerChunk;  // NOLINT
+    chunks_.push_back(chunkCurr_);
+  }
+  return std::exchange(chunkCurr_, chunkCurr_ + slotSize_);  // NOLINT
+}
+
+////////////////////////////////////////////////////////////////////////////////
+inline void NodeArenaResource::deallocate(void* ptr, std::size_t size,
+                                          std::size_t alignment) noexcept {
+  if (!isSlotSized_(size, alignment)) {
+    ::operator delete(ptr, std::align_val_t{alignment});
+    return;
+  }
+  freeList_ = ::new (ptr) FreeSlot_{freeList_};
+}
+
+////////////////////////////////////////////////////////////////////////////////
+inline void NodeArenaResource::clear() noexcept {
+  for (std::byte* chunk : chunks_) {
+    ::operator delete(chunk, std::align_val_t{slotAlign_});
+  }
+  chunks_.clear();
+  freeList_ = nullptr;
+  chunkCurr_ = nullptr;
+  chunkEnd_ = nullptr;
+}
+
+}  // namespace impl
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief The NodeArena<T> class. Allocator tuned for dynamic segment tree
+/// nodes, which are always allocated in pairs.
+///
+/// \tparam T allocated type.
+///
+/// Copies and rebound copies of an arena share the memory. Pair slots are
+/// carved out of large chunks and reused through a free list. A tree, which
+/// is the only owner of its arena, releases all nodes in O(chunks) on
+/// destruction. Not thread safe.
+///
+template <class T>
+class NodeArena {
+ public:
+  using value_type = T;
+
+ public:
+  NodeArena() : resource_(std::make_shared<impl::NodeArenaResource>()) {
+  }
+
+  template <class U>
+  NodeArena(const NodeArena<U>& other) noexcept  // NOLINT
+      : resource_(other.resource_) {
+  }
+
+  T* allocate(std::size_t n) {
+    return static_cast<T*>(resource_->allocate(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T* ptr, std::size_t n) noexcept {
+    resource_->deallocate(ptr, n * sizeof(T), alignof(T));
+  }
+
+  /**
+   * @brief Release all memory of the arena at once. Objects allocated from
+   * it must not be used or deallocated after this call.
+   */
+  void clear() noexcept {
+    resource_->clear();
+  }
+
+  /**
+   * @brief Release all memory if this arena is not shared with other
+   * allocators.
+   *
+   * @return true if memory was released.
+   */
+  bool clearIfExclusive() noexcept {
+    if (resource_.use_count() != 1) {
+      return false;
+    }
+    resource_->clear();
+    return true;
+  }
+
+  [[nodiscard]] std::size_t chunksCount() const {
+    return resource_->chunksCount();
+  }
+
+  template <class U>
+  bool operator==(const NodeArena<U>& other) const noexcept {
+    return resource_ == other.resource_;
+  }
+
+ private:
+  std::shared_ptr<impl::NodeArenaResource> resource_;
+
+ private:
+  template <class U>
+  friend class NodeArena;
+};
+
+}  // namespace dst
+
+#endif  // NODE_ARENA_HPP
@@ -16,10 +16,14 @@ namespace dst {
 template <std::integral KeyT, class ValueT, class GetValueT = ValueT,
           class UpdateOp = NoUpdateOp,
           class UpdateArgT = mp::DefaultUpdateArgT<UpdateOp, ValueT>,
-          class Allocator = std::allocator<ValueT>>
+          class Allocator = std::allocator<ValueT>,
+          class GetCachePolicy = NoRangeGetCache,
+          class UpdateCompose = NoUpdateCompose,
+          class CoalescePolicy = NoLeafCoalescing>
 using DynamicAvgSegmentTree =
     DynamicSegmentTree<KeyT, ValueT, GetValueT, comb::Avg<GetValueT, KeyT>,
-                       std::identity, UpdateOp, UpdateArgT, Allocator>;
+                       std::identity, UpdateOp, UpdateArgT, Allocator,
+                       GetCachePolicy, UpdateCompose, CoalescePolicy>;
 
 }  // namespace dst
 
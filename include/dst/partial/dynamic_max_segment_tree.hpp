@@ -15,10 +15,14 @@ namespace dst {
 
 template <std::integral KeyT, class ValueT, class UpdateOp = NoUpdateOp,
           class UpdateArgT = mp::DefaultUpdateArgT<UpdateOp, ValueT>,
-          class Allocator = std::allocator<ValueT>>
+          class Allocator = std::allocator<ValueT>,
+          class GetCachePolicy = NoRangeGetCache,
+          class UpdateCompose = NoUpdateCompose,
+          class CoalescePolicy = NoLeafCoalescing>
 using DynamicMaxSegmentTree =
     DynamicSegmentTree<KeyT, ValueT, ValueT, comb::Max<ValueT>, std::identity,
-                       UpdateOp, UpdateArgT, Allocator>;
+                       UpdateOp, UpdateArgT, Allocator, GetCachePolicy,
+                       UpdateCompose, CoalescePolicy>;
 
 }  // namespace dst
 
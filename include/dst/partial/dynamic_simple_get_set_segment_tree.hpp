@@ -16,10 +16,12 @@
 namespace dst {
 
 template <std::integral KeyT, class ValueT,
-          class Allocator = std::allocator<ValueT>>
+          class Allocator = std::allocator<ValueT>,
+          class CoalescePolicy = NoLeafCoalescing>
 using DynamicSimpleGetSetSegmentTree =
     DynamicSegmentTree<KeyT, ValueT, void, NoRangeGetOp, NoRangeGetOp,
-                       NoUpdateOp, void, Allocator>;
+                       NoUpdateOp, void, Allocator, NoRangeGetCache,
+                       NoUpdateCompose, CoalescePolicy>;
 
 }  // namespace dst
 
@@ -10,19 +10,24 @@
 #include <concepts>
 #include <dst/comb.hpp>
 #include <dst/dynamic_segment_tree.hpp>
+#include <dst/key_range.hpp>
 
 namespace dst {
 
 template <std::integral KeyT, class ValueT, class GetValueT = ValueT,
           class UpdateOp = NoUpdateOp,
           class UpdateArgT = mp::DefaultUpdateArgT<UpdateOp, ValueT>,
-          class Allocator = std::allocator<ValueT>>
+          class Allocator = std::allocator<ValueT>,
+          class GetCachePolicy = NoRangeGetCache,
+          class UpdateCompose = NoUpdateCompose,
+          class CoalescePolicy = NoLeafCoalescing>
 using DynamicSumSegmentTree = DynamicSegmentTree<
     KeyT, ValueT, GetValueT, comb::Sum<GetValueT>,
     decltype([](const ValueT& val, KeyT begin, KeyT end) -> GetValueT {
-      return static_cast<GetValueT>(val) * (end - begin);
+      return static_cast<GetValueT>(val) * impl::keyDistance(begin, end);
     }),
-    UpdateOp, UpdateArgT, Allocator>;
+    UpdateOp, UpdateArgT, Allocator, GetCachePolicy, UpdateCompose,
+    CoalescePolicy>;
 
 }  // namespace dst
 
@@ -0,0 +1,559 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright Georgy Guminov 2023-2024.
+// Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt
+// or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef PERSISTENT_DYNAMIC_SEGMENT_TREE_HPP
+#define PERSISTENT_DYNAMIC_SEGMENT_TREE_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <dst/concepts.hpp>
+#include <dst/disable_operations.hpp>
+#include <dst/impl/dynamic_segment_tree_range_get_variation_base.hpp>
+#include <dst/impl/pending.hpp>
+#include <dst/key_range.hpp>
+#include <dst/mp.hpp>
+#include <dst/upd.hpp>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace dst {
+
+namespace impl {
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief The PersistentNode<ValueT, PendingT> class. Node of a persistent
+/// tree.
+///
+/// Children pair may be shared between versions of a tree. A shared pair is
+/// never changed. `value` is meaningful only for leaves.
+///
+template <class ValueT, class PendingT>
+struct PersistentNode {
+  ValueT value;
+  std::shared_ptr<std::array<PersistentNode, 2>> children{};
+  [[no_unique_address]] PendingT pending{};
+
+  [[nodiscard]] bool isLeaf() const {
+    return !children;
+  }
+
+  [[nodiscard]] bool hasPendingUpdate() const {
+    return isPending(pending);
+  }
+
+  [[nodiscard]] const auto& getPendingUpdate() const {
+    return *pending;
+  }
+};
+
+}  // namespace impl
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief The PersistentDynamicSegmentTree class. Dynamic segment tree with
+/// O(1) snapshots.
+///
+/// Template parameters have the same meaning as for DynamicSegmentTree.
+/// Children pairs are reference counted and shared between versions, so
+/// copying a tree and `snapshot()` only copy the root. Set and update
+/// operations copy shared pairs on their paths (copy-on-write) and change
+/// pairs owned by this version only in place. A snapshot or a copy stays
+/// unchanged while the tree is modified, and may be queried from other
+/// threads.
+///
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb = NoRangeGetOp,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit =
+              NoRangeGetOp,
+          class UpdateOp = NoUpdateOp,
+          class UpdateArgT = mp::DefaultUpdateArgT<UpdateOp, ValueT>,
+          class Allocator = std::allocator<ValueT>>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+class PersistentDynamicSegmentTree
+    : protected impl::DynamicSegmentTreeRangeGetCombineVariationBase<
+          KeyT, GetValueT, SegGetComb>,
+      protected impl::DynamicSegmentTreeRangeGetInitVariationBase<
+          KeyT, ValueT, GetValueT, SegGetInit> {
+ private:
+  using RangeGetCombineVariationBase_ =
+      impl::DynamicSegmentTreeRangeGetCombineVariationBase<KeyT, GetValueT,
+                                                           SegGetComb>;
+
+  using RangeGetInitVariationBase_ =
+      impl::DynamicSegmentTreeRangeGetInitVariationBase<KeyT, ValueT,
+                                                        GetValueT, SegGetInit>;
+
+  using Pending_ = impl::NodePending<UpdateOp, ValueT, UpdateArgT>::Type;
+  using Node_ = impl::PersistentNode<ValueT, Pending_>;
+  using Pair_ = std::array<Node_, 2>;
+  using PairAlloc_ =
+      std::allocator_traits<Allocator>::template rebind_alloc<Pair_>;
+
+  constexpr static bool kOneArgUpdate_ = conc::OneArgUpdateOp<UpdateOp, ValueT>;
+  constexpr static bool kTwoArgsUpdate_ =
+      !kOneArgUpdate_ && !std::is_same_v<UpdateOp, NoUpdateOp>;
+
+  // Values are only calculated if there are update operations.
+  using GetResult_ = std::conditional_t<std::is_same_v<UpdateOp, NoUpdateOp>,
+                                        const ValueT&, ValueT>;
+
+  using PendingPath_ = impl::PendingPath<UpdateOp, ValueT, UpdateArgT, KeyT>;
+
+ public:
+  class Snapshot;
+
+ public:
+  /**
+   * @brief Construct a new Persistent Dynamic Segment Tree object.
+   *
+   * @param begin beginning of a working area.
+   * @param end ending of a working area (not included).
+   * @param value default filling value.
+   * @param segGetComb functor called when two segments are combined in
+   * range get operation.
+   * @param segGetInit functor called for get result initialization on an
+   * equally filled segment.
+   * @param updateOp update operation.
+   * @param alloc allocator.
+   */
+  PersistentDynamicSegmentTree(KeyT begin, KeyT end,
+                               const ValueT& value = ValueT{},
+                               const SegGetComb& segGetComb = SegGetComb{},
+                               const SegGetInit& segGetInit = SegGetInit{},
+                               const UpdateOp& updateOp = UpdateOp{},
+                               const Allocator& alloc = Allocator{});
+
+  /**
+   * @brief Set value on a range.
+   *
+   * If `begin` >= `end`, then set operation range is perceived as empty and no
+   * changes happen.
+   *
+   * @param begin beginning of an updated segment.
+   * @param end ending of an updated segment (not included).
+   * @param toSet value to set.
+   */
+  void set(KeyT begin, KeyT end, const ValueT& toSet);
+
+  /**
+   * @brief Apply update operation with an argument on a range.
+   *
+   * @param begin beginning of an updated segment.
+   * @param end ending of an updated segment (not included).
+   * @param toUpdate argument for update operation.
+   */
+  template <class UpdateArgT1 = UpdateArgT>
+    requires conc::TwoArgsUpdateOp<UpdateOp, ValueT, UpdateArgT1>
+  void update(KeyT begin, KeyT end, const UpdateArgT1& toUpdate);
+
+  /**
+   * @brief Apply no arguments update operation on a range.
+   *
+   * @param begin beginning of an updated segment.
+   * @param end ending of an updated segment (not included).
+   */
+  void update(KeyT begin, KeyT end)
+    requires conc::OneArgUpdateOp<UpdateOp, ValueT>;
+
+  /**
+   * @brief Get value by index.
+   *
+   * @param key index.
+   * @return value in index.
+   */
+  GetResult_ get(KeyT key) const;
+
+  /**
+   * @brief Get result on a range.
+   *
+   * @param begin beginning of a range.
+   * @param end ending of a range.
+   * @return range get operation result.
+   */
+  GetValueT rangeGet(KeyT begin, KeyT end) const
+    requires conc::GetCombiner<SegGetComb, GetValueT, KeyT> &&
+             conc::GetInitializer<SegGetInit, ValueT, KeyT, GetValueT>;
+
+  /**
+   * @brief Take an immutable view of the current version of the tree in
+   * O(1).
+   *
+   * @return snapshot.
+   */
+  Snapshot snapshot() const;
+
+ private:
+  void setImpl_(KeyT begin, KeyT end, KeyT currBegin, KeyT currEnd,
+                Node_& node, const ValueT& toSet);
+  template <class... UpdateArgs>
+  void updateImpl_(KeyT begin, KeyT end, KeyT currBegin, KeyT currEnd,
+                   Node_& node, const UpdateArgs&... toUpdate);
+  GetValueT rangeGetImpl_(KeyT begin, KeyT end, KeyT currBegin, KeyT currEnd,
+                          const Node_& node, PendingPath_& path) const;
+
+  template <class... UpdateArgs>
+  void applyUpdate_(Node_& node, const UpdateArgs&... toUpdate) const;
+  void siftUpdate_(Node_& node) const;
+  Pair_& ownChildren_(Node_& node) const;
+
+ private:
+  Node_ root_;
+  [[no_unique_address]] UpdateOp updateOp_;
+  [[no_unique_address]] PairAlloc_ pairAllocator_;
+  KeyT begin_;
+  KeyT end_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief The Snapshot class. Immutable version of a persistent tree.
+///
+/// Shares nodes with the tree it was taken from. Copying is O(1).
+///
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+class PersistentDynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb,
+                                   SegGetInit, UpdateOp, UpdateArgT,
+                                   Allocator>::Snapshot {
+ public:
+  /**
+   * @brief Get value by index.
+   *
+   * @param key index.
+   * @return value in index.
+   */
+  GetResult_ get(KeyT key) const {
+    return tree_.get(key);
+  }
+
+  /**
+   * @brief Get result on a range.
+   *
+   * @param begin beginning of a range.
+   * @param end ending of a range.
+   * @return range get operation result.
+   */
+  GetValueT rangeGet(KeyT begin, KeyT end) const
+    requires conc::GetCombiner<SegGetComb, GetValueT, KeyT> &&
+             conc::GetInitializer<SegGetInit, ValueT, KeyT, GetValueT>
+  {
+    return tree_.rangeGet(begin, end);
+  }
+
+ private:
+  explicit Snapshot(const PersistentDynamicSegmentTree& tree) : tree_(tree) {
+  }
+
+ private:
+  PersistentDynamicSegmentTree tree_;
+
+ private:
+  friend class PersistentDynamicSegmentTree;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+PersistentDynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                             UpdateOp, UpdateArgT, Allocator>::
+    PersistentDynamicSegmentTree(KeyT begin, KeyT end, const ValueT& value,
+                                 const SegGetComb& segGetComb,
+                                 const SegGetInit& segGetInit,
+                                 const UpdateOp& updateOp,
+                                 const Allocator& alloc)
+    : RangeGetCombineVariationBase_(segGetComb),
+      RangeGetInitVariationBase_(segGetInit),
+      root_{value},
+      updateOp_(updateOp),
+      pairAllocator_(alloc),
+      begin_(begin),
+      end_(end) {
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+void PersistentDynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb,
+                                  SegGetInit, UpdateOp, UpdateArgT,
+                                  Allocator>::set(KeyT begin, KeyT end,
+                                                  const ValueT& toSet) {
+  if (begin < end) {
+    setImpl_(begin, end, begin_, end_, root_, toSet);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+template <class UpdateArgT1>
+  requires conc::TwoArgsUpdateOp<UpdateOp, ValueT, UpdateArgT1>
+void PersistentDynamicSegmentTree<
+    KeyT, ValueT, GetValueT, SegGetComb, SegGetInit, UpdateOp, UpdateArgT,
+    Allocator>::update(KeyT begin, KeyT end, const UpdateArgT1& toUpdate) {
+  updateImpl_(begin, end, begin_, end_, root_, toUpdate);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+void PersistentDynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb,
+                                  SegGetInit, UpdateOp, UpdateArgT,
+                                  Allocator>::update(KeyT begin, KeyT end)
+  requires conc::OneArgUpdateOp<UpdateOp, ValueT>
+{
+  updateImpl_(begin, end, begin_, end_, root_);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+auto PersistentDynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb,
+                                  SegGetInit, UpdateOp, UpdateArgT,
+                                  Allocator>::get(KeyT key) const
+    -> GetResult_ {
+  if (key >= end_ || key < begin_) {
+    std::stringstream messageStream;
+    messageStream << "Get operation for " << key << ", which is out of range.";
+    throw std::out_of_range(messageStream.str());
+  }
+  auto currBegin = begin_;
+  auto currEnd = end_;
+  auto path = PendingPath_{};
+  const Node_* currNode = &root_;
+  while (!currNode->isLeaf()) {
+    path.push(*currNode);
+    const auto mid = impl::midpoint(currBegin, currEnd);
+    if (key >= mid) {
+      currBegin = mid;
+      currNode = &(*currNode->children)[1];
+    } else {
+      currEnd = mid;
+      currNode = &(*currNode->children)[0];
+    }
+  }
+  return path.apply(updateOp_, currNode->value);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+GetValueT
+PersistentDynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                             UpdateOp, UpdateArgT,
+                             Allocator>::rangeGet(KeyT begin, KeyT end) const
+  requires conc::GetCombiner<SegGetComb, GetValueT, KeyT> &&
+           conc::GetInitializer<SegGetInit, ValueT, KeyT, GetValueT>
+{
+  auto path = PendingPath_{};
+  return rangeGetImpl_(begin, end, begin_, end_, root_, path);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+auto PersistentDynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb,
+                                  SegGetInit, UpdateOp, UpdateArgT,
+                                  Allocator>::snapshot() const -> Snapshot {
+  return Snapshot(*this);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+void PersistentDynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb,
+                                  SegGetInit, UpdateOp, UpdateArgT, Allocator>::
+    setImpl_(KeyT begin, KeyT end, KeyT currBegin, KeyT currEnd, Node_& node,
+             const ValueT& toSet) {
+  assert(currBegin < end && "currBegin must be checked before call.");
+  assert(currEnd > begin && "currEnd must be checked before call.");
+  if (end >= currEnd && begin <= currBegin) {
+    node = Node_{toSet};
+    return;
+  }
+  Pair_& children = ownChildren_(node);
+  const auto mid = impl::midpoint(currBegin, currEnd);
+  if (mid > begin) {
+    setImpl_(begin, end, currBegin, mid, children[0], toSet);
+  }
+  if (mid < end) {
+    setImpl_(begin, end, mid, currEnd, children[1], toSet);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+template <class... UpdateArgs>
+void PersistentDynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb,
+                                  SegGetInit, UpdateOp, UpdateArgT, Allocator>::
+    updateImpl_(KeyT begin, KeyT end, KeyT currBegin, KeyT currEnd,
+                Node_& node, const UpdateArgs&... toUpdate) {
+  if (begin >= currEnd || currBegin >= end) {
+    return;
+  }
+  if (end >= currEnd && begin <= currBegin) {
+    applyUpdate_(node, toUpdate...);
+    return;
+  }
+  Pair_& children = ownChildren_(node);
+  const auto mid = impl::midpoint(currBegin, currEnd);
+  updateImpl_(begin, end, currBegin, mid, children[0], toUpdate...);
+  updateImpl_(begin, end, mid, currEnd, children[1], toUpdate...);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+GetValueT
+PersistentDynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                             UpdateOp, UpdateArgT, Allocator>::
+    rangeGetImpl_(KeyT begin, KeyT end, KeyT currBegin, KeyT currEnd,
+                  const Node_& node, PendingPath_& path) const {
+  if (node.isLeaf()) {
+    // Leaf segment is filled with one value, so there is no need to split it.
+    return RangeGetInitVariationBase_::initGet_(
+        std::max(currBegin, begin), std::min(currEnd, end),
+        path.apply(updateOp_, node.value));
+  }
+  const auto mid = impl::midpoint(currBegin, currEnd);
+  const Pair_& children = *node.children;
+
+  path.push(node);
+  auto ret = [&]() -> GetValueT {
+    if (begin >= mid) {  // only right
+      return rangeGetImpl_(begin, end, mid, currEnd, children[1], path);
+    }
+    if (end <= mid) {  // only left
+      return rangeGetImpl_(begin, end, currBegin, mid, children[0], path);
+    }
+    const GetValueT lVal =
+        rangeGetImpl_(begin, end, currBegin, mid, children[0], path);
+    const GetValueT rVal =
+        rangeGetImpl_(begin, end, mid, currEnd, children[1], path);
+    return RangeGetCombineVariationBase_::combineGet_(
+        lVal, rVal, std::max(currBegin, begin), mid, std::min(currEnd, end));
+  }();
+  path.pop(node);
+  return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+template <class... UpdateArgs>
+void PersistentDynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb,
+                                  SegGetInit, UpdateOp, UpdateArgT, Allocator>::
+    applyUpdate_(Node_& node, const UpdateArgs&... toUpdate) const {
+  if (node.isLeaf()) {
+    node.value = updateOp_(node.value, toUpdate...);
+    return;
+  }
+  if constexpr (kTwoArgsUpdate_) {
+    if (node.pending.has_value()) {
+      siftUpdate_(node);
+    }
+    node.pending.emplace(toUpdate...);
+  } else {
+    impl::addPendingFlag<UpdateOp>(node.pending, [&] { siftUpdate_(node); });
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+void PersistentDynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb,
+                                  SegGetInit, UpdateOp, UpdateArgT,
+                                  Allocator>::siftUpdate_(Node_& node) const {
+  ownChildren_(node);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template <std::integral KeyT, class ValueT, class GetValueT,
+          conc::OptGetCombiner<GetValueT, KeyT> SegGetComb,
+          conc::OptGetInitializer<ValueT, KeyT, GetValueT> SegGetInit,
+          class UpdateOp, class UpdateArgT, class Allocator>
+  requires conc::OptUpdateOp<UpdateOp, ValueT, UpdateArgT>
+auto PersistentDynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb,
+                                  SegGetInit, UpdateOp, UpdateArgT,
+                                  Allocator>::ownChildren_(Node_& node) const
+    -> Pair_& {
+  if (node.isLeaf()) {
+    node.children = std::allocate_shared<Pair_>(
+        pairAllocator_, Pair_{Node_{node.value}, Node_{node.value}});
+    return *node.children;
+  }
+  if (node.children.use_count() != 1) {
+    node.children = std::allocate_shared<Pair_>(pairAllocator_,
+                                                std::as_const(*node.children));
+  } else {
+    // Other versions may have just released the pair.
+    std::atomic_thread_fence(std::memory_order_acquire);
+  }
+  Pair_& children = *node.children;
+  // Delayed update of the node is pushed into owned children.
+  if constexpr (kTwoArgsUpdate_) {
+    if (node.pending.has_value()) {
+      applyUpdate_(children[0], *node.pending);
+      applyUpdate_(children[1], *node.pending);
+      node.pending.reset();
+    }
+  } else if constexpr (kOneArgUpdate_) {
+    if (node.pending) {
+      applyUpdate_(children[0]);
+      applyUpdate_(children[1]);
+      node.pending = false;
+    }
+  }
+  return children;
+}
+
+}  // namespace dst
+
+#endif  // PERSISTENT_DYNAMIC_SEGMENT_TREE_HPP
@@ -0,0 +1,53 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright Georgy Guminov 2023-2024.
+// Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt
+// or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef POLICIES_HPP
+#define POLICIES_HPP
+
+namespace dst {
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Range get results are not stored in nodes. Fully covered internal
+/// nodes are traversed down to leaves on each rangeGet.
+struct NoRangeGetCache {};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Each internal node stores rangeGet result of its segment. Fully
+/// covered subtrees are answered without traversal, which makes rangeGet
+/// logarithmic on fragmented trees. The cost is one combiner call per visited
+/// level in set operations. It is only allowed for trees without update
+/// operation, see RangeGetCacheWithUpdate.
+struct RangeGetCache {};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief RangeGetCache for trees with update operation.
+///
+/// \tparam CacheUpdateOp operation, which applies an update to a rangeGet
+/// result of a segment: `(const GetValueT& result, const UpdateArgT& arg,
+/// KeyT begin, KeyT end) -> GetValueT`, or `(result, begin, end) ->
+/// GetValueT` for updates without an argument.
+///
+/// A cached result of a covered node is updated in place, so update keeps its
+/// cost. Updates delayed above a node are applied to its cached result on the
+/// fly, so rangeGet stays logarithmic after updates. See dst::cache_upd.
+template <class CacheUpdateOp>
+struct RangeGetCacheWithUpdate {
+  using Op = CacheUpdateOp;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Children of a node are kept even if they are equal leaves.
+struct NoLeafCoalescing {};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Two sibling leaves holding equal values are merged back into their
+/// parent on the way up out of set and update operations. It keeps a tree,
+/// which is filled with a few long runs, small.
+struct CoalesceEqualLeaves {};
+
+}  // namespace dst
+
+#endif  // POLICIES_HPP
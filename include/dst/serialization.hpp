@@ -0,0 +1,96 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright Georgy Guminov 2023-2024.
+// Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt
+// or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef SERIALIZATION_HPP
+#define SERIALIZATION_HPP
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace dst {
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief The Serializer<T> class. Binary serialization of values and update
+/// arguments of a tree.
+///
+/// \tparam T serialized type.
+///
+/// Trivially copyable types are written as raw bytes, so the format depends
+/// on the platform byte order. Specialize it for other types with static
+/// `void write(std::ostream&, const T&)` and `T read(std::istream&)`.
+///
+template <class T>
+struct Serializer;
+
+template <class T>
+  requires std::is_trivially_copyable_v<T>
+struct Serializer<T> {
+  static void write(std::ostream& out, const T& value) {
+    const auto bytes = std::bit_cast<std::array<char, sizeof(T)>>(value);
+    out.write(bytes.data(), bytes.size());
+  }
+
+  static T read(std::istream& in) {
+    auto bytes = std::array<char, sizeof(T)>();
+    in.read(bytes.data(), bytes.size());
+    return std::bit_cast<T>(bytes);
+  }
+};
+
+namespace impl {
+
+constexpr auto kSerializationMagic = std::array<char, 4>{'D', 'S', 'T', '2'};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Write bits packed by eight into bytes.
+inline void writeBits(std::ostream& out, const std::vector<bool>& bits) {
+  auto byte = std::uint8_t{0};
+  for (std::size_t i = 0; i < bits.size(); ++i) {
+    byte |= static_cast<std::uint8_t>(bits[i]) << (i % 8);
+    if (i % 8 == 7 || i + 1 == bits.size()) {
+      out.put(static_cast<char>(byte));
+      byte = 0;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Throw if a stream failed while reading a tree.
+inline void checkReadStream(const std::istream& in) {
+  if (!in) {
+    throw std::runtime_error("Failed to read a serialized tree.");
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Read `count` bits written by writeBits. Bits are stored as bytes
+/// are read, so a corrupted count fails on the end of a stream instead of
+/// allocating memory for all of them.
+inline std::vector<bool> readBits(std::istream& in, std::size_t count) {
+  auto bits = std::vector<bool>();
+  auto byte = std::uint8_t{0};
+  for (std::size_t i = 0; i < count; ++i) {
+    if (i % 8 == 0) {
+      byte = static_cast<std::uint8_t>(in.get());
+      checkReadStream(in);
+    }
+    bits.push_back(((byte >> (i % 8)) & 1) != 0);
+  }
+  return bits;
+}
+
+}  // namespace impl
+
+}  // namespace dst
+
+#endif  // SERIALIZATION_HPP
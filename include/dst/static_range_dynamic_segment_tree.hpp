@@ -0,0 +1,119 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright Georgy Guminov 2023-2024.
+// Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt
+// or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef STATIC_RANGE_DYNAMIC_SEGMENT_TREE_HPP
+#define STATIC_RANGE_DYNAMIC_SEGMENT_TREE_HPP
+
+#include <bit>
+#include <concepts>
+#include <dst/disable_operations.hpp>
+#include <dst/dynamic_segment_tree.hpp>
+#include <dst/key_range.hpp>
+#include <dst/mp.hpp>
+#include <dst/policies.hpp>
+#include <memory>
+#include <type_traits>
+
+namespace dst {
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief The StaticRangeDynamicSegmentTree class. Dynamic segment tree with
+/// a working area [Begin, End), which is known at compile time.
+///
+/// \tparam KeyT integral key type.
+/// \tparam Begin beginning of a working area.
+/// \tparam End ending of a working area (not included). End - Begin must be a
+/// power of two.
+///
+/// Other parameters are the same as of DynamicSegmentTree. All operations
+/// are inherited, and nodes are split the same way. Since every segment is
+/// halved evenly, get chooses children by bits of `key - Begin`, and its
+/// bounds check and the first bit are compile-time constants.
+///
+template <std::integral KeyT, KeyT Begin, KeyT End, class ValueT,
+          class GetValueT = ValueT, class SegGetComb = NoRangeGetOp,
+          class SegGetInit = NoRangeGetOp, class UpdateOp = NoUpdateOp,
+          class UpdateArgT = mp::DefaultUpdateArgT<UpdateOp, ValueT>,
+          class Allocator = std::allocator<ValueT>,
+          class GetCachePolicy = NoRangeGetCache,
+          class UpdateCompose = NoUpdateCompose,
+          class CoalescePolicy = NoLeafCoalescing>
+  requires(Begin < End && std::has_single_bit(impl::keyDistance(Begin, End)))
+class StaticRangeDynamicSegmentTree
+    : public DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb,
+                                SegGetInit, UpdateOp, UpdateArgT, Allocator,
+                                GetCachePolicy, UpdateCompose, CoalescePolicy> {
+ private:
+  using Base_ =
+      DynamicSegmentTree<KeyT, ValueT, GetValueT, SegGetComb, SegGetInit,
+                         UpdateOp, UpdateArgT, Allocator, GetCachePolicy,
+                         UpdateCompose, CoalescePolicy>;
+
+  constexpr static auto kHalf_ = impl::keyDistance(Begin, End) / 2;
+
+ public:
+  constexpr static KeyT kBegin = Begin;
+  constexpr static KeyT kEnd = End;
+
+ public:
+  /**
+   * @brief Construct a new Static Range Dynamic Segment Tree object.
+   *
+   * @param value default filling value.
+   * @param segGetComb functor called when two segments are combined in
+   * range get operation.
+   * @param segGetInit functor called for get result initialization on an
+   * equally filled segment.
+   * @param updateOp update operation.
+   * @param alloc allocator.
+   */
+  explicit StaticRangeDynamicSegmentTree(
+      const ValueT& value, const SegGetComb& segGetComb = SegGetComb{},
+      const SegGetInit& segGetInit = SegGetInit{},
+      const UpdateOp& updateOp = UpdateOp{},
+      const Allocator& alloc = Allocator{})
+      : Base_(Begin, End, value, segGetComb, segGetInit, updateOp, alloc) {
+  }
+
+  /**
+   * @brief Construct a new Static Range Dynamic Segment Tree object moving
+   * filling value.
+   *
+   * @param value default filling value.
+   * @param segGetComb functor called when two segments are combined in
+   * range get operation.
+   * @param segGetInit functor called for get result initialization on an
+   * equally filled segment.
+   * @param updateOp update operation.
+   * @param alloc allocator.
+   */
+  explicit StaticRangeDynamicSegmentTree(
+      ValueT&& value = ValueT{}, const SegGetComb& segGetComb = SegGetComb{},
+      const SegGetInit& segGetInit = SegGetInit{},
+      const UpdateOp& updateOp = UpdateOp{},
+      const Allocator& alloc = Allocator{})
+      : Base_(Begin, End, std::move(value), segGetComb, segGetInit, updateOp,
+              alloc) {
+  }
+
+  /**
+   * @brief Get value by index.
+   *
+   * @param key index.
+   * @return value in index. It is a copy with delayed updates applied if
+   * the tree has an update operation, and a reference otherwise.
+   */
+  decltype(auto) get(KeyT key) const {
+    if (key < Begin || key >= End) {
+      Base_::throwGetOutOfRange_(key);
+    }
+    return Base_::getByOffsetBits_(impl::keyDistance(Begin, key), kHalf_);
+  }
+};
+
+}  // namespace dst
+
+#endif  // STATIC_RANGE_DYNAMIC_SEGMENT_TREE_HPP
@@ -4,6 +4,11 @@
 // Version 1.0. (See accompanying file LICENSE_1_0.txt
 // or copy at https://www.boost.org/LICENSE_1_0.txt)
 
+#ifndef UPD_HPP
+#define UPD_HPP
+
+#include <type_traits>
+
 namespace dst::upd {
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -18,4 +23,54 @@ struct Negate {
   };
 };
 
+////////////////////////////////////////////////////////////////////////////////
+/// \brief The BitwiseNot<ValueT> class. Bitwise not update operation.
+///
+/// \tparam ValueT value type
+///
+template <class ValueT>
+struct BitwiseNot {
+  ValueT operator()(const ValueT& val) const {
+    return ~val;
+  };
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief The IsInvolution<UpdateOp> trait.
+///
+/// \tparam UpdateOp one argument update operation.
+///
+/// Specialize it with std::true_type base for operations, applying which
+/// twice gives the original value. Two pending updates of such an operation
+/// cancel each other and are not pushed down to children.
+///
+template <class UpdateOp>
+struct IsInvolution : std::false_type {};
+
+template <class ValueT>
+struct IsInvolution<Negate<ValueT>> : std::true_type {};
+
+template <class ValueT>
+struct IsInvolution<BitwiseNot<ValueT>> : std::true_type {};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief The IsIdempotent<UpdateOp> trait.
+///
+/// \tparam UpdateOp one argument update operation.
+///
+/// Specialize it with std::true_type base for operations, applying which
+/// twice gives the same result as applying once. Second pending update of
+/// such an operation is dropped.
+///
+template <class UpdateOp>
+struct IsIdempotent : std::false_type {};
+
+template <class UpdateOp>
+constexpr bool kIsInvolution = IsInvolution<UpdateOp>::value;
+
+template <class UpdateOp>
+constexpr bool kIsIdempotent = IsIdempotent<UpdateOp>::value;
+
 }  // namespace dst::upd
+
+#endif  // UPD_HPP
@@ -10,9 +10,11 @@
 #include <boost/container/adaptive_pool.hpp>
 #include <boost/container/allocator.hpp>
 #include <dst/disable_operations.hpp>
+#include <dst/node_arena.hpp>
 #include <dst/partial/dynamic_simple_get_set_segment_tree.hpp>
 #include <random>
 #include <ranges>
+#include <vector>
 
 #include "reference/seg_tree_reference_base.hpp"
 #include "tools/generate_index_range.hpp"
@@ -33,7 +35,7 @@ class AllocatorsCommonTest : public testing::Test {
 
 using MyTypes =
     ::testing::Types<std::allocator<int>, boost::container::adaptive_pool<int>,
-                     boost::container::allocator<int>>;
+                     boost::container::allocator<int>, dst::NodeArena<int>>;
 
 TYPED_TEST_SUITE(AllocatorsCommonTest, MyTypes);
 
@@ -109,6 +111,32 @@ TYPED_TEST(AllocatorsCommonTest, SetAndCopyAssign) {
   EXPECT_TRUE(equal(kExpectedVals, treeVals));
 }
 
+TYPED_TEST(AllocatorsCommonTest, CopyAndClearDeepTree) {
+  using DST = TestFixture::template DST<size_t, int>;
+
+  constexpr auto kTreeEnd = size_t{1} << 48;
+  auto tree = DST(0, kTreeEnd, 0);
+
+  constexpr auto kGenSeed = 42U;
+  std::mt19937 generator(kGenSeed);
+  auto keyDistr = std::uniform_int_distribution<size_t>(0, kTreeEnd - 2);
+  auto keys = std::vector<size_t>(300);
+  for (auto& key : keys) {
+    key = keyDistr(generator);
+  }
+  for (auto i : iota(size_t{0}, keys.size())) {
+    tree.set(keys[i], keys[i] + 1, static_cast<int>(i) + 1);
+  }
+
+  auto copy = std::as_const(tree);
+  tree = DST(0, 1, 0);
+
+  for (auto i : iota(size_t{0}, keys.size())) {
+    EXPECT_EQ(copy.get(keys[i]), static_cast<int>(i) + 1);
+  }
+  EXPECT_EQ(copy.get(kTreeEnd - 1), 0);
+}
+
 TYPED_TEST(AllocatorsCommonTest, SetAndMove) {
   using DST = TestFixture::template DST<size_t, int>;
 
@@ -202,5 +230,49 @@ TYPED_TEST(AllocatorsCommonTest, FuzzGetSetMixed) {
   }
 };
 
+TEST(NodeArena, ReuseFreedSlots) {
+  using DST = dst::DynamicSimpleGetSetSegmentTree<size_t, int,
+                                                  dst::NodeArena<int>>;
+  const auto arena = dst::NodeArena<int>();
+  constexpr auto kTreeEnd = size_t{1 << 16};
+  auto tree = DST(0, kTreeEnd, 0, {}, {}, {}, arena);
+
+  for (size_t i : iota(size_t{0}, size_t{1000})) {
+    tree.set(i * 61, i * 61 + 1, 1);
+    tree.set(0, kTreeEnd, 0);
+  }
+
+  EXPECT_EQ(arena.chunksCount(), 1);
+  EXPECT_EQ(tree.get(61), 0);
+}
+
+TEST(NodeArena, SharedBetweenCopies) {
+  using DST = dst::DynamicSimpleGetSetSegmentTree<size_t, int,
+                                                  dst::NodeArena<int>>;
+  constexpr auto kTreeEnd = size_t{1000};
+  auto tree = DST(0, kTreeEnd, 0);
+  auto reference = SegTreeReferenceBase<size_t, int>(0, kTreeEnd, 0);
+
+  std::mt19937 generator(17);
+
+  for ([[maybe_unused]] size_t i : iota(0, 100)) {
+    const auto [rngBegin, rngEnd] = GenerateIndRng(0, kTreeEnd)(generator);
+    const auto valueToSet = std::uniform_int_distribution(0, 1000)(generator);
+    tree.set(rngBegin, rngEnd, valueToSet);
+    reference.set(rngBegin, rngEnd, valueToSet);
+  }
+
+  {
+    const auto copy = std::as_const(tree);
+    for (size_t idx : iota(size_t{0}, kTreeEnd)) {
+      EXPECT_EQ(copy.get(idx), reference.get(idx));
+    }
+  }
+
+  for (size_t idx : iota(size_t{0}, kTreeEnd)) {
+    EXPECT_EQ(tree.get(idx), reference.get(idx));
+  }
+}
+
 // NOLINTEND(cppcoreguidelines-avoid-non-const-global-variables,
 // cert-err58-cpp, cert-msc32-c)
@@ -6,7 +6,11 @@
 
 #include <gtest/gtest.h>
 
+#include <dst/compose.hpp>
 #include <dst/impl/node.hpp>
+#include <dst/upd.hpp>
+#include <cstdint>
+#include <cstdlib>
 
 #include "tools/copy_n_times_then_throw.hpp"
 
@@ -20,6 +24,23 @@ TEST(Node, Construct) {
   EXPECT_TRUE(node.isLeaf());
 }
 
+////////////////////////////////////////////////////////////////////////////////
+TEST(Node, TrivialValueIsStoredWithoutFlag) {
+  EXPECT_EQ(sizeof(dst::impl::Node<std::int64_t, void>), 16);
+  EXPECT_EQ(sizeof(dst::impl::Node<std::int64_t, bool>), 24);
+
+  auto node = dst::impl::Node<std::int64_t, void>{2};
+  auto alloc = std::allocator<dst::impl::Node<std::int64_t, void>>();
+  node.initChildren(alloc);
+
+  EXPECT_FALSE(node.hasValue());
+  EXPECT_TRUE(node.getLeft()->hasValue());
+  EXPECT_EQ(node.getLeft()->getValue(), 2);
+  EXPECT_EQ(node.getRight()->getValue(), 2);
+
+  node.clearChildren(alloc);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 TEST(Node, UpdateBool) {
   auto node = dst::impl::Node<int, bool>{2};
@@ -47,6 +68,84 @@ TEST(Node, UpdateInt) {
   EXPECT_EQ(node.getValue(), 5);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+TEST(Node, ComposedUpdateIsNotPushedToChildren) {
+  using Node = dst::impl::Node<int, std::optional<int>>;
+  auto node = Node{2};
+
+  using UpdateOp = decltype([](int n, int toAdd) {
+    return n + toAdd;
+  });
+  auto alloc = std::allocator<Node>();
+  node.initChildren(alloc);
+  node.update(UpdateOp{}, 3, alloc, dst::compose::Sum<int>{});
+  node.update(UpdateOp{}, 4, alloc, dst::compose::Sum<int>{});
+
+  EXPECT_EQ(node.getLeft()->getValue(), 2);
+  EXPECT_EQ(node.getRight()->getValue(), 2);
+
+  node.siftOptUpdate(UpdateOp{}, alloc, dst::compose::Sum<int>{});
+
+  EXPECT_EQ(node.getLeft()->getValue(), 9);
+  EXPECT_EQ(node.getRight()->getValue(), 9);
+
+  node.clearChildren(alloc);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+TEST(Node, InvolutionUpdatesCancel) {
+  using Node = dst::impl::Node<int, bool>;
+  auto node = Node{2};
+
+  auto alloc = std::allocator<Node>();
+  node.initChildren(alloc);
+  node.update(dst::upd::Negate<int>{}, alloc);
+  node.update(dst::upd::Negate<int>{}, alloc);
+  node.update(dst::upd::Negate<int>{}, alloc);
+
+  EXPECT_EQ(node.getLeft()->getValue(), 2);
+  EXPECT_EQ(node.getRight()->getValue(), 2);
+
+  node.siftOptUpdate(dst::upd::Negate<int>{}, alloc);
+
+  EXPECT_EQ(node.getLeft()->getValue(), -2);
+  EXPECT_EQ(node.getRight()->getValue(), -2);
+
+  node.clearChildren(alloc);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+struct Abs {
+  int operator()(int val) const {
+    return std::abs(val);
+  }
+};
+
+template <>
+struct dst::upd::IsIdempotent<Abs> : std::true_type {};
+
+////////////////////////////////////////////////////////////////////////////////
+TEST(Node, IdempotentUpdatesAbsorb) {
+  using Node = dst::impl::Node<int, bool>;
+  auto node = Node{-2};
+
+  auto alloc = std::allocator<Node>();
+  node.initChildren(alloc);
+  node.getLeft()->setValue(-3, alloc);
+  node.update(Abs{}, alloc);
+  node.update(Abs{}, alloc);
+
+  EXPECT_EQ(node.getLeft()->getValue(), -3);
+  EXPECT_EQ(node.getRight()->getValue(), -2);
+
+  node.siftOptUpdate(Abs{}, alloc);
+
+  EXPECT_EQ(node.getLeft()->getValue(), 3);
+  EXPECT_EQ(node.getRight()->getValue(), 2);
+
+  node.clearChildren(alloc);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 TEST(Node, InitChildren) {
   auto node = dst::impl::Node<int, bool>{2};
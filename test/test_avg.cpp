@@ -9,6 +9,8 @@
 #include <dst/partial/dynamic_avg_segment_tree.hpp>
 #include <random>
 #include <ranges>
+#include <utility>
+#include <vector>
 
 #include "reference/avg_seg_tree_reference.hpp"
 #include "tools/generate_index_range.hpp"
@@ -150,5 +152,34 @@ TEST(DynamicAvgSegmentTree, FuzzTestMixedSetUpdateRangeGet) {
   }
 }
 
+TEST(DynamicAvgSegmentTree, RangeGetBatch) {
+  constexpr auto kTreeEnd = size_t{1000};
+  auto tree = DynamicAvgSegmentTree<size_t, float>(0, kTreeEnd, 0.f);
+  auto reference = AvgSegTreeReference<size_t, float>(0, kTreeEnd, 0.f);
+
+  constexpr auto kGenSeed = 17U;
+  std::mt19937 gen(kGenSeed);
+
+  for ([[maybe_unused]] size_t iterNum : iota(0, 100)) {
+    const auto [rngBegin, rngEnd] = GenerateIndRng(0, kTreeEnd)(gen);
+    const auto valToSet = std::uniform_real_distribution(1.f, 1000.f)(gen);
+    tree.set(rngBegin, rngEnd, valToSet);
+    reference.set(rngBegin, rngEnd, valToSet);
+  }
+
+  auto ranges = std::vector<std::pair<size_t, size_t>>();
+  for ([[maybe_unused]] size_t iterNum : iota(0, 50)) {
+    const auto [rngBegin, rngEnd] = GenerateIndRng(0, kTreeEnd)(gen);
+    ranges.emplace_back(rngBegin, std::max(rngEnd, rngBegin + 1));
+  }
+  auto results = std::vector<float>(ranges.size());
+  tree.rangeGetBatch(ranges, results);
+
+  for (size_t i : iota(size_t{0}, ranges.size())) {
+    const auto refRes = reference.rangeGet(ranges[i].first, ranges[i].second);
+    EXPECT_LE(std::abs((results[i] - refRes) / refRes), 1e-4);
+  }
+}
+
 // NOLINTEND(cppcoreguidelines-owning-memory, cert-msc51-cpp, cert-msc32-c,
 // cert-err58-cpp)
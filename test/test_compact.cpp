@@ -0,0 +1,200 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright Georgy Guminov 2023-2024.
+// Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt
+//  or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <dst/comb.hpp>
+#include <dst/compact_dynamic_segment_tree.hpp>
+#include <dst/upd.hpp>
+#include <functional>
+#include <random>
+#include <ranges>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "reference/sum_seg_tree_reference.hpp"
+#include "tools/generate_index_range.hpp"
+
+using std::size_t;
+using std::views::iota;
+using GenerateIndRng = GenerateIndexRange<size_t>;
+
+namespace {
+
+using SumInit = decltype([](int val, size_t begin, size_t end) {
+  return val * static_cast<int>(end - begin);
+});
+
+using CompactSumTree =
+    dst::CompactDynamicSegmentTree<size_t, int, int, dst::comb::Sum<int>,
+                                   SumInit, std::plus<int>, int>;
+
+using CompactNegateTree =
+    dst::CompactDynamicSegmentTree<size_t, int, int, dst::comb::Sum<int>,
+                                   SumInit, dst::upd::Negate<int>>;
+
+}  // namespace
+
+// NOLINTBEGIN(cppcoreguidelines-*, cert-*, readability-magic-numbers,
+// cert-err58-cpp)
+
+TEST(CompactDynamicSegmentTree, SetAndGet) {
+  auto tree = CompactSumTree(0, 42, 5);
+  tree.set(3, 17, 8);
+
+  EXPECT_EQ(tree.get(2), 5);
+  EXPECT_EQ(tree.get(3), 8);
+  EXPECT_EQ(tree.get(16), 8);
+  EXPECT_EQ(tree.get(17), 5);
+  EXPECT_EQ(tree.rangeGet(0, 42), 5 * 28 + 8 * 14);
+}
+
+TEST(CompactDynamicSegmentTree, FreedNodesAreReused) {
+  auto tree = CompactSumTree(0, 1024, 0);
+
+  for (size_t i : iota(size_t{0}, size_t{100})) {
+    tree.set(i * 7, i * 7 + 1, 1);
+    tree.set(0, 1024, 0);
+    EXPECT_EQ(tree.nodesCount(), 1);
+  }
+}
+
+TEST(CompactDynamicSegmentTree, ManyPointSets) {
+  constexpr auto kTreeEnd = size_t{1} << 17;
+  auto tree = CompactSumTree(0, kTreeEnd, 0);
+
+  // Every even key is set, so all the tree down to single keys is built.
+  for (size_t key = 0; key < kTreeEnd; key += 2) {
+    tree.set(key, key + 1, 1);
+  }
+
+  EXPECT_EQ(tree.nodesCount(), 2 * kTreeEnd - 1);
+  EXPECT_EQ(tree.rangeGet(0, kTreeEnd), static_cast<int>(kTreeEnd / 2));
+  EXPECT_EQ(tree.get(kTreeEnd - 2), 1);
+  EXPECT_EQ(tree.get(kTreeEnd - 1), 0);
+}
+
+TEST(CompactDynamicSegmentTree, CopyIsIndependent) {
+  auto tree = CompactSumTree(0, 100, 1);
+  tree.set(10, 20, 2);
+
+  auto copy = tree;
+  copy.update(0, 100, 3);
+
+  EXPECT_EQ(tree.get(15), 2);
+  EXPECT_EQ(copy.get(15), 5);
+  EXPECT_EQ(tree.rangeGet(0, 100), 110);
+  EXPECT_EQ(copy.rangeGet(0, 100), 410);
+}
+
+TEST(CompactDynamicSegmentTree, FuzzTestMixedSetUpdateRangeGet) {
+  constexpr auto treeEnd = size_t{1000};
+  auto tree = CompactSumTree(0, treeEnd, 0);
+  auto reference = SumSegTreeReference<size_t, int>(0, treeEnd, 0);
+
+  std::mt19937 generator(54);
+
+  for (size_t i : iota(0, 300)) {
+    const auto [rngBegin, rngEnd] = GenerateIndRng(0, treeEnd)(generator);
+    const auto val = std::uniform_int_distribution(0, 1000)(generator);
+    if (std::bernoulli_distribution()(generator)) {
+      tree.set(rngBegin, rngEnd, val);
+      reference.set(rngBegin, rngEnd, val);
+    } else {
+      tree.update(rngBegin, rngEnd, val);
+      reference.update(rngBegin, rngEnd, std::plus<>(), val);
+    }
+    const auto [getBegin, getEnd] = GenerateIndRng(0, treeEnd)(generator);
+    if (getBegin < getEnd) {
+      EXPECT_EQ(tree.rangeGet(getBegin, getEnd),
+                reference.rangeGet(getBegin, getEnd));
+    }
+  }
+
+  for (size_t idx : iota(size_t{0}, treeEnd)) {
+    EXPECT_EQ(tree.get(idx), reference.get(idx));
+  }
+}
+
+TEST(CompactDynamicSegmentTree, ConcurrentQueries) {
+  constexpr auto treeEnd = size_t{1000};
+  auto tree = CompactSumTree(0, treeEnd, 0);
+  auto reference = SumSegTreeReference<size_t, int>(0, treeEnd, 0);
+
+  std::mt19937 generator(12);
+
+  for (size_t i : iota(0, 200)) {
+    const auto [rngBegin, rngEnd] = GenerateIndRng(0, treeEnd)(generator);
+    const auto val = std::uniform_int_distribution(0, 1000)(generator);
+    if (std::bernoulli_distribution(0.3)(generator)) {
+      tree.set(rngBegin, rngEnd, val);
+      reference.set(rngBegin, rngEnd, val);
+    } else {
+      tree.update(rngBegin, rngEnd, val);
+      reference.update(rngBegin, rngEnd, std::plus<>(), val);
+    }
+  }
+
+  const auto& constTree = tree;
+  auto mismatches = std::vector<size_t>(4, 0);
+  auto threads = std::vector<std::thread>();
+  for (size_t threadIdx : iota(size_t{0}, mismatches.size())) {
+    threads.emplace_back([&, threadIdx] {
+      std::mt19937 threadGenerator(threadIdx);
+      for (size_t i : iota(0, 2000)) {
+        const auto [getBegin, getEnd] =
+            GenerateIndRng(0, treeEnd)(threadGenerator);
+        if (getBegin < getEnd && constTree.rangeGet(getBegin, getEnd) !=
+                                     reference.rangeGet(getBegin, getEnd)) {
+          ++mismatches[threadIdx];
+        }
+        if (constTree.get(getBegin % treeEnd) !=
+            reference.get(getBegin % treeEnd)) {
+          ++mismatches[threadIdx];
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(mismatches, std::vector<size_t>(4, 0));
+}
+
+TEST(CompactDynamicSegmentTree, NegateFuzzTest) {
+  constexpr auto treeEnd = size_t{1000};
+  auto tree = CompactNegateTree(0, treeEnd, 42);
+  auto reference = SumSegTreeReference<size_t, int>(0, treeEnd, 42);
+
+  std::mt19937 generator(37);
+
+  for (size_t i : iota(0, 300)) {
+    const auto [rngBegin, rngEnd] = GenerateIndRng(0, treeEnd)(generator);
+    if (std::bernoulli_distribution(0.2)(generator)) {
+      const auto val = std::uniform_int_distribution(0, 1000)(generator);
+      tree.set(rngBegin, rngEnd, val);
+      reference.set(rngBegin, rngEnd, val);
+    } else {
+      tree.update(rngBegin, rngEnd);
+      reference.update(rngBegin, rngEnd, std::negate<>());
+    }
+    const auto [getBegin, getEnd] = GenerateIndRng(0, treeEnd)(generator);
+    if (getBegin < getEnd) {
+      EXPECT_EQ(tree.rangeGet(getBegin, getEnd),
+                reference.rangeGet(getBegin, getEnd));
+    }
+  }
+
+  for (size_t idx : iota(size_t{0}, treeEnd)) {
+    EXPECT_EQ(tree.get(idx), reference.get(idx));
+  }
+}
+
+// NOLINTEND(cppcoreguidelines-*, cert-*, readability-magic-numbers,
+// cert-err58-cpp)
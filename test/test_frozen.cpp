@@ -0,0 +1,152 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright Georgy Guminov 2023-2024.
+// Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt
+//  or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <dst/frozen_segment_tree.hpp>
+#include <dst/partial/dynamic_avg_segment_tree.hpp>
+#include <dst/partial/dynamic_sum_segment_tree.hpp>
+#include <functional>
+#include <random>
+#include <ranges>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "tools/generate_index_range.hpp"
+
+using dst::DynamicSumSegmentTree;
+using dst::FrozenSegmentTreeFor;
+using std::size_t;
+using std::views::iota;
+using GenerateIndRng = GenerateIndexRange<size_t>;
+
+namespace {
+
+template <class Tree>
+std::vector<std::byte> freezeToBytes(const Tree& tree) {
+  auto stream = std::stringstream();
+  FrozenSegmentTreeFor<Tree>::freeze(tree, stream);
+  const auto data = stream.str();
+  auto ret = std::vector<std::byte>(data.size());
+  std::ranges::transform(data, ret.begin(),
+                         [](char chr) { return static_cast<std::byte>(chr); });
+  return ret;
+}
+
+}  // namespace
+
+// NOLINTBEGIN(cppcoreguidelines-*, cert-*, readability-magic-numbers,
+// cert-err58-cpp)
+
+TEST(FrozenSegmentTree, SumTreeWithPendingUpdates) {
+  constexpr auto treeEnd = size_t{1000};
+  using Tree = DynamicSumSegmentTree<size_t, int, int, std::plus<int>, int>;
+  auto tree = Tree(0, treeEnd, 3);
+
+  std::mt19937 generator(21);
+
+  for (size_t i : iota(0, 200)) {
+    const auto [rngBegin, rngEnd] = GenerateIndRng(0, treeEnd)(generator);
+    const auto val = std::uniform_int_distribution(0, 1000)(generator);
+    if (std::bernoulli_distribution()(generator)) {
+      tree.set(rngBegin, rngEnd, val);
+    } else {
+      tree.update(rngBegin, rngEnd, val);
+    }
+  }
+
+  const auto image = freezeToBytes(tree);
+  const auto frozen = FrozenSegmentTreeFor<Tree>(image);
+
+  for (size_t idx : iota(size_t{0}, treeEnd)) {
+    EXPECT_EQ(frozen.get(idx), tree.get(idx));
+  }
+  for (size_t i : iota(0, 500)) {
+    const auto [rngBegin, rngEnd] = GenerateIndRng(0, treeEnd)(generator);
+    EXPECT_EQ(frozen.rangeGet(rngBegin, rngEnd),
+              tree.rangeGet(rngBegin, rngEnd));
+  }
+  EXPECT_THROW(frozen.get(treeEnd), std::out_of_range);
+}
+
+TEST(FrozenSegmentTree, AvgTree) {
+  using Tree = dst::DynamicAvgSegmentTree<int, float, float>;
+  auto tree = Tree(-20, 40, 1.f);
+  tree.set(-7, 12, 4.f);
+  tree.set(30, 31, -2.f);
+
+  const auto image = freezeToBytes(tree);
+  const auto frozen = FrozenSegmentTreeFor<Tree>(image);
+
+  EXPECT_FLOAT_EQ(frozen.rangeGet(-20, 40), tree.rangeGet(-20, 40));
+  EXPECT_FLOAT_EQ(frozen.rangeGet(-8, 31), tree.rangeGet(-8, 31));
+  EXPECT_FLOAT_EQ(frozen.get(30), -2.f);
+}
+
+TEST(FrozenSegmentTree, InvalidImageThrows) {
+  using Tree = DynamicSumSegmentTree<int, int>;
+  auto tree = Tree(0, 100, 1);
+  tree.set(3, 70, 2);
+
+  auto image = freezeToBytes(tree);
+  using Frozen = FrozenSegmentTreeFor<Tree>;
+
+  EXPECT_THROW(Frozen(std::span(image).first(image.size() - 1)),
+               std::invalid_argument);
+  image[0] = std::byte{'X'};
+  EXPECT_THROW(Frozen{image}, std::invalid_argument);
+}
+
+TEST(FrozenSegmentTree, EmptyWorkingAreaThrows) {
+  using Tree = DynamicSumSegmentTree<int, int>;
+  const auto tree = Tree(5, 5, 1);
+  auto stream = std::stringstream();
+
+  EXPECT_THROW(FrozenSegmentTreeFor<Tree>::freeze(tree, stream),
+               std::invalid_argument);
+}
+
+TEST(FrozenSegmentTree, FullKeyRangeTreeThrows) {
+  using Tree = DynamicSumSegmentTree<std::uint32_t, int>;
+  const auto tree = Tree(dst::kFullKeyRange, 1);
+  auto stream = std::stringstream();
+
+  EXPECT_THROW(FrozenSegmentTreeFor<Tree>::freeze(tree, stream),
+               std::invalid_argument);
+}
+
+TEST(FrozenSegmentTree, CorruptedNodesThrow) {
+  using Tree = DynamicSumSegmentTree<int, int>;
+  auto tree = Tree(0, 100, 1);
+  tree.set(3, 70, 2);
+
+  const auto image = freezeToBytes(tree);
+  using Frozen = FrozenSegmentTreeFor<Tree>;
+  // Root node follows the header.
+  constexpr auto kRootChildrenOffset =
+      sizeof(dst::impl::FrozenHeader<int>) +
+      offsetof(dst::impl::FrozenNode<int>, children);
+
+  const auto withRootChildren = [&](std::uint32_t children) {
+    auto corrupted = image;
+    std::memcpy(&corrupted[kRootChildrenOffset], &children, sizeof(children));
+    return corrupted;
+  };
+
+  EXPECT_NO_THROW(Frozen{withRootChildren(1)});
+  EXPECT_THROW(Frozen{withRootChildren(0xFFFFFFF0)}, std::invalid_argument);
+  EXPECT_THROW(Frozen{withRootChildren(3)}, std::invalid_argument);
+  EXPECT_THROW(Frozen{withRootChildren(0)}, std::invalid_argument);
+}
+
+// NOLINTEND(cppcoreguidelines-*, cert-*, readability-magic-numbers,
+// cert-err58-cpp)
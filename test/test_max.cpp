@@ -7,11 +7,13 @@
 #include <gtest/gtest.h>
 
 #include <array>
+#include <dst/cache_upd.hpp>
 #include <dst/partial/dynamic_max_segment_tree.hpp>
 #include <random>
 #include <range/v3/view/reverse.hpp>
 #include <range/v3/view/zip.hpp>
 #include <ranges>
+#include <utility>
 
 #include "reference/max_seg_tree_reference.hpp"
 #include "tools/generate_index_range.hpp"
@@ -442,5 +444,71 @@ TEST(DynamicMaxSegmentTree, FuzzTestMixedSetUpdateRangeGet) {
   }
 }
 
+TEST(DynamicMaxSegmentTree, RangeArgMaxFuzzTest) {
+  constexpr auto kTreeEnd = size_t{500};
+  auto tree =
+      DynamicMaxSegmentTree<size_t, int, std::plus<int>, int>(0, kTreeEnd, 0);
+  auto reference = MaxSegTreeReference<size_t, int>(0, kTreeEnd, 0);
+
+  constexpr auto kGenSeed = 19U;
+  std::mt19937 generator(kGenSeed);
+
+  for ([[maybe_unused]] size_t iterNum : iota(0, 200)) {
+    const auto [rngBegin, rngEnd] = GenerateIndRng(0, kTreeEnd)(generator);
+    const auto val = std::uniform_int_distribution(-20, 20)(generator);
+    if (std::bernoulli_distribution()(generator)) {
+      tree.set(rngBegin, rngEnd, val);
+      reference.set(rngBegin, rngEnd, val);
+    } else {
+      tree.update(rngBegin, rngEnd, val);
+      reference.update(rngBegin, rngEnd, std::plus<>(), val);
+    }
+    const auto [getBegin, getEnd] = GenerateIndRng(0, kTreeEnd)(generator);
+    if (getBegin < getEnd) {
+      auto expected = std::pair(getBegin, reference.get(getBegin));
+      for (size_t key = getBegin + 1; key < getEnd; ++key) {
+        if (reference.get(key) > expected.second) {
+          expected = std::pair(key, reference.get(key));
+        }
+      }
+      EXPECT_EQ(tree.rangeArgMax(getBegin, getEnd), expected);
+    }
+  }
+}
+
+TEST(DynamicMaxSegmentTree, CachedRangeArgMaxFuzzTest) {
+  constexpr auto kTreeEnd = size_t{500};
+  auto tree = DynamicMaxSegmentTree<
+      size_t, int, std::plus<int>, int, std::allocator<int>,
+      dst::RangeGetCacheWithUpdate<dst::cache_upd::AddToExtreme<int>>>(
+      0, kTreeEnd, 0);
+  auto reference = MaxSegTreeReference<size_t, int>(0, kTreeEnd, 0);
+
+  constexpr auto kGenSeed = 20U;
+  std::mt19937 generator(kGenSeed);
+
+  for ([[maybe_unused]] size_t iterNum : iota(0, 200)) {
+    const auto [rngBegin, rngEnd] = GenerateIndRng(0, kTreeEnd)(generator);
+    const auto val = std::uniform_int_distribution(-20, 20)(generator);
+    if (std::bernoulli_distribution()(generator)) {
+      tree.set(rngBegin, rngEnd, val);
+      reference.set(rngBegin, rngEnd, val);
+    } else {
+      tree.update(rngBegin, rngEnd, val);
+      reference.update(rngBegin, rngEnd, std::plus<>(), val);
+    }
+    const auto [getBegin, getEnd] = GenerateIndRng(0, kTreeEnd)(generator);
+    if (getBegin < getEnd) {
+      auto expected = std::pair(getBegin, reference.get(getBegin));
+      for (size_t key = getBegin + 1; key < getEnd; ++key) {
+        if (reference.get(key) > expected.second) {
+          expected = std::pair(key, reference.get(key));
+        }
+      }
+      EXPECT_EQ(tree.rangeArgMax(getBegin, getEnd), expected);
+    }
+  }
+}
+
 // NOLINTEND(cppcoreguidelines-owning-memory, cert-err58-cpp, cert-msc51-cpp,
 // cert-msc32-c)
@@ -7,11 +7,15 @@
 #include <gtest/gtest.h>
 
 #include <cstddef>
+#include <dst/cache_upd.hpp>
 #include <dst/partial/dynamic_min_segment_tree.hpp>
+#include <optional>
 #include <random>
 #include <range/v3/view/reverse.hpp>
 #include <range/v3/view/zip.hpp>
 #include <ranges>
+#include <utility>
+#include <vector>
 
 #include "reference/min_seg_tree_reference.hpp"
 #include "tools/generate_index_range.hpp"
@@ -54,6 +58,14 @@ TEST(DynamicMinSegmentTree, RangeGetAfterUpdate) {
   EXPECT_EQ(tree.rangeGet(12, 18), 34 + 4);
 }
 
+TEST(DynamicMinSegmentTree, RangeGetBatchOutOfWorkingArea) {
+  auto tree = DynamicMinSegmentTree<int, int>(0, 16, 5);
+  const auto ranges = std::vector<std::pair<int, int>>{{-3, 4}, {12, 20}};
+  auto results = std::vector<int>(ranges.size(), -100);
+  tree.rangeGetBatch(ranges, results);
+  EXPECT_EQ(results, (std::vector<int>{5, 5}));
+}
+
 TEST(DynamicMinSegmentTree, RangeGetAfterSet) {
   constexpr auto kTreeEnd = 42;
   constexpr auto kFillValue = 34;
@@ -442,5 +454,137 @@ TEST(DynamicMinSegmentTree, FuzzTestMixedSetUpdateRangeGet) {
   }
 }
 
+TEST(DynamicMinSegmentTree, CachedFuzzTestMixedSetUpdateRangeGet) {
+  constexpr auto kTreeEnd = size_t{1000};
+  auto tree = DynamicMinSegmentTree<
+      size_t, int, std::plus<int>, int, std::allocator<int>,
+      dst::RangeGetCacheWithUpdate<dst::cache_upd::AddToExtreme<int>>>(
+      0, kTreeEnd, 0);
+  auto reference = MinSegTreeReference<size_t, int>(0, kTreeEnd, 0);
+
+  constexpr auto kGenSeed = 37U;
+  std::mt19937 generator(kGenSeed);
+
+  for ([[maybe_unused]] size_t iterNum : iota(0, 300)) {
+    const auto [rngBegin, rngEnd] = GenerateIndRng(0, kTreeEnd)(generator);
+    if (std::bernoulli_distribution()(generator)) {
+      const auto setVal = std::uniform_int_distribution(0, 1000)(generator);
+      tree.set(rngBegin, rngEnd, setVal);
+      reference.set(rngBegin, rngEnd, setVal);
+    } else {
+      const auto updVal = std::uniform_int_distribution(0, 1000)(generator);
+      tree.update(rngBegin, rngEnd, updVal);
+      reference.update(rngBegin, rngEnd, std::plus<>(), updVal);
+    }
+    const auto [getBegin, getEnd] = GenerateIndRng(0, kTreeEnd)(generator);
+    if (getBegin < getEnd) {
+      EXPECT_EQ(tree.rangeGet(getBegin, getEnd),
+                reference.rangeGet(getBegin, getEnd));
+    }
+    EXPECT_EQ(tree.rangeGet(0, kTreeEnd), reference.rangeGet(0, kTreeEnd));
+  }
+}
+
+TEST(DynamicMinSegmentTree, FindFirstLessThanFuzzTest) {
+  constexpr auto kTreeEnd = size_t{500};
+  auto tree = DynamicMinSegmentTree<size_t, int, std::plus<int>, int>(
+      0, kTreeEnd, 1000);
+  auto reference = MinSegTreeReference<size_t, int>(0, kTreeEnd, 1000);
+
+  constexpr auto kGenSeed = 13U;
+  std::mt19937 generator(kGenSeed);
+
+  for ([[maybe_unused]] size_t iterNum : iota(0, 200)) {
+    const auto [rngBegin, rngEnd] = GenerateIndRng(0, kTreeEnd)(generator);
+    const auto val = std::uniform_int_distribution(-100, 100)(generator);
+    if (std::bernoulli_distribution()(generator)) {
+      tree.set(rngBegin, rngEnd, val);
+      reference.set(rngBegin, rngEnd, val);
+    } else {
+      tree.update(rngBegin, rngEnd, val);
+      reference.update(rngBegin, rngEnd, std::plus<>(), val);
+    }
+    const auto [findBegin, findEnd] = GenerateIndRng(0, kTreeEnd)(generator);
+    const auto bound = std::uniform_int_distribution(-100, 1000)(generator);
+
+    auto expected = std::optional<size_t>();
+    for (size_t key = findBegin; key < findEnd; ++key) {
+      if (reference.get(key) < bound) {
+        expected = key;
+        break;
+      }
+    }
+    EXPECT_EQ(tree.findFirst(findBegin, findEnd,
+                             [bound](int min) { return min < bound; }),
+              expected);
+  }
+}
+
+TEST(DynamicMinSegmentTree, RangeArgMinFuzzTest) {
+  constexpr auto kTreeEnd = size_t{500};
+  auto tree =
+      DynamicMinSegmentTree<size_t, int, std::plus<int>, int>(0, kTreeEnd, 0);
+  auto reference = MinSegTreeReference<size_t, int>(0, kTreeEnd, 0);
+
+  constexpr auto kGenSeed = 17U;
+  std::mt19937 generator(kGenSeed);
+
+  for ([[maybe_unused]] size_t iterNum : iota(0, 200)) {
+    const auto [rngBegin, rngEnd] = GenerateIndRng(0, kTreeEnd)(generator);
+    const auto val = std::uniform_int_distribution(-20, 20)(generator);
+    if (std::bernoulli_distribution()(generator)) {
+      tree.set(rngBegin, rngEnd, val);
+      reference.set(rngBegin, rngEnd, val);
+    } else {
+      tree.update(rngBegin, rngEnd, val);
+      reference.update(rngBegin, rngEnd, std::plus<>(), val);
+    }
+    const auto [getBegin, getEnd] = GenerateIndRng(0, kTreeEnd)(generator);
+    if (getBegin < getEnd) {
+      auto expected = std::pair(getBegin, reference.get(getBegin));
+      for (size_t key = getBegin + 1; key < getEnd; ++key) {
+        if (reference.get(key) < expected.second) {
+          expected = std::pair(key, reference.get(key));
+        }
+      }
+      EXPECT_EQ(tree.rangeArgMin(getBegin, getEnd), expected);
+    }
+  }
+}
+
+TEST(DynamicMinSegmentTree, CachedRangeArgMinFuzzTest) {
+  constexpr auto kTreeEnd = size_t{500};
+  auto tree = DynamicMinSegmentTree<
+      size_t, int, std::plus<int>, int, std::allocator<int>,
+      dst::RangeGetCacheWithUpdate<dst::cache_upd::AddToExtreme<int>>>(
+      0, kTreeEnd, 0);
+  auto reference = MinSegTreeReference<size_t, int>(0, kTreeEnd, 0);
+
+  constexpr auto kGenSeed = 18U;
+  std::mt19937 generator(kGenSeed);
+
+  for ([[maybe_unused]] size_t iterNum : iota(0, 200)) {
+    const auto [rngBegin, rngEnd] = GenerateIndRng(0, kTreeEnd)(generator);
+    const auto val = std::uniform_int_distribution(-20, 20)(generator);
+    if (std::bernoulli_distribution()(generator)) {
+      tree.set(rngBegin, rngEnd, val);
+      reference.set(rngBegin, rngEnd, val);
+    } else {
+      tree.update(rngBegin, rngEnd, val);
+      reference.update(rngBegin, rngEnd, std::plus<>(), val);
+    }
+    const auto [getBegin, getEnd] = GenerateIndRng(0, kTreeEnd)(generator);
+    if (getBegin < getEnd) {
+      auto expected = std::pair(getBegin, reference.get(getBegin));
+      for (size_t key = getBegin + 1; key < getEnd; ++key) {
+        if (reference.get(key) < expected.second) {
+          expected = std::pair(key, reference.get(key));
+        }
+      }
+      EXPECT_EQ(tree.rangeArgMin(getBegin, getEnd), expected);
+    }
+  }
+}
+
 // NOLINTEND(cppcoreguidelines-owning-memory, cert-err58-cpp, cert-msc51-cpp,
 // cert-msc32-c)
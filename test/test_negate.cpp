@@ -6,6 +6,8 @@
 
 #include <gtest/gtest.h>
 
+#include <dst/cache_upd.hpp>
+#include <dst/comb.hpp>
 #include <dst/partial/dynamic_negate_segment_tree.hpp>
 #include <random>
 #include <ranges>
@@ -290,5 +292,96 @@ TEST(DynamicNegateSegmentTree, UpdatePlusSetFuzzTest) {
   }
 }
 
+TEST(DynamicNegateSegmentTree, LeavesAfterUpdates) {
+  constexpr auto kTreeEnd = size_t{1000};
+  constexpr auto kFillValue = 42;
+  auto tree = NegateSumDynamicSegmentTree<size_t, int>(0, kTreeEnd, kFillValue);
+  auto reference = SegTreeReferenceBase<size_t, int>(0, kTreeEnd, kFillValue);
+
+  constexpr auto kGenSeed = 73U;
+  auto gen = std::mt19937(kGenSeed);
+
+  for (size_t iterNum : iota(0, 200)) {
+    const auto [rngBegin, rngEnd] = GenerateIndRng(0, kTreeEnd)(gen);
+    tree.update(rngBegin, rngEnd);
+    reference.update(rngBegin, rngEnd, knegateOp);
+  }
+
+  auto prevEnd = size_t{0};
+  for (const auto& [segBegin, segEnd, value] : tree.leaves()) {
+    EXPECT_EQ(segBegin, prevEnd);
+    for (size_t idx : iota(segBegin, segEnd)) {
+      EXPECT_EQ(value, reference.get(idx));
+    }
+    prevEnd = segEnd;
+  }
+  EXPECT_EQ(prevEnd, kTreeEnd);
+}
+
+TEST(DynamicNegateSegmentTree, UpdateAndGetFuzzTest) {
+  constexpr auto kTreeEnd = size_t{300};
+  constexpr auto kFillVal = 3;
+  auto tree = dst::DynamicNegateSegmentTree<
+      size_t, int, int, dst::comb::Sum<int>,
+      decltype([](int val, size_t begin, size_t end) {
+        return val * static_cast<int>(end - begin);
+      })>(0, kTreeEnd, kFillVal);
+  auto reference = SegTreeReferenceBase<size_t, int>(0, kTreeEnd, kFillVal);
+
+  constexpr auto kGenSeed = 41U;
+  auto gen = std::mt19937(kGenSeed);
+
+  for ([[maybe_unused]] size_t iterNum : iota(0, 100)) {
+    const auto [rngBegin, rngEnd] = GenerateIndRng(0, kTreeEnd)(gen);
+    if (rngBegin == rngEnd) {
+      continue;
+    }
+    reference.update(rngBegin, rngEnd, knegateOp);
+    auto expected = 0;
+    for (size_t idx : iota(rngBegin, rngEnd)) {
+      expected += reference.get(idx);
+    }
+    EXPECT_EQ(tree.updateAndGet(rngBegin, rngEnd), expected);
+  }
+}
+
+TEST(DynamicNegateSegmentTree, CachedFuzzTestMixedSetUpdateRangeGet) {
+  constexpr auto kTreeEnd = size_t{500};
+  constexpr auto kFillVal = 3;
+  auto tree = dst::DynamicSegmentTree<
+      size_t, int, int, dst::comb::Sum<int>,
+      decltype([](int val, size_t begin, size_t end) {
+        return val * static_cast<int>(end - begin);
+      }),
+      dst::upd::Negate<int>, void, std::allocator<int>,
+      dst::RangeGetCacheWithUpdate<dst::cache_upd::NegateSum<int>>>(
+      0, kTreeEnd, kFillVal);
+  auto reference = SegTreeReferenceBase<size_t, int>(0, kTreeEnd, kFillVal);
+
+  constexpr auto kGenSeed = 43U;
+  auto gen = std::mt19937(kGenSeed);
+
+  for ([[maybe_unused]] size_t iterNum : iota(0, 300)) {
+    const auto [rngBegin, rngEnd] = GenerateIndRng(0, kTreeEnd)(gen);
+    if (std::bernoulli_distribution(0.3)(gen)) {
+      const auto valueToSet = std::uniform_int_distribution(0, 1000)(gen);
+      tree.set(rngBegin, rngEnd, valueToSet);
+      reference.set(rngBegin, rngEnd, valueToSet);
+    } else {
+      tree.update(rngBegin, rngEnd);
+      reference.update(rngBegin, rngEnd, knegateOp);
+    }
+    const auto [getBegin, getEnd] = GenerateIndRng(0, kTreeEnd)(gen);
+    if (getBegin == getEnd) {
+      continue;
+    }
+    auto expected = 0;
+    for (size_t idx : iota(getBegin, getEnd)) {
+      expected += reference.get(idx);
+    }
+    EXPECT_EQ(tree.rangeGet(getBegin, getEnd), expected);
+  }
+}
+
 // NOLINTEND(cppcoreguidelines-owning-memory, cert-err58-cpp, cert-msc51-cpp,
 // cert-msc32-c)
@@ -0,0 +1,193 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright Georgy Guminov 2023-2024.
+// Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt
+//  or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <dst/comb.hpp>
+#include <dst/persistent_dynamic_segment_tree.hpp>
+#include <dst/upd.hpp>
+#include <functional>
+#include <random>
+#include <ranges>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "reference/sum_seg_tree_reference.hpp"
+#include "tools/counting_allocator.hpp"
+#include "tools/generate_index_range.hpp"
+
+using std::size_t;
+using std::views::iota;
+using GenerateIndRng = GenerateIndexRange<size_t>;
+
+namespace {
+
+using SumInit = decltype([](int val, size_t begin, size_t end) {
+  return val * static_cast<int>(end - begin);
+});
+
+using PersistentSumTree =
+    dst::PersistentDynamicSegmentTree<size_t, int, int, dst::comb::Sum<int>,
+                                      SumInit, std::plus<int>, int>;
+
+using PersistentNegateTree =
+    dst::PersistentDynamicSegmentTree<size_t, int, int, dst::comb::Sum<int>,
+                                      SumInit, dst::upd::Negate<int>>;
+
+}  // namespace
+
+// NOLINTBEGIN(cppcoreguidelines-*, cert-*, readability-magic-numbers,
+// cert-err58-cpp)
+
+TEST(PersistentDynamicSegmentTree, SnapshotIsNotChangedByWriters) {
+  auto tree = PersistentSumTree(0, 100, 1);
+  tree.set(10, 20, 2);
+
+  const auto snapshot = tree.snapshot();
+  tree.update(0, 100, 3);
+  tree.set(15, 50, 0);
+
+  EXPECT_EQ(snapshot.get(15), 2);
+  EXPECT_EQ(snapshot.rangeGet(0, 100), 110);
+  EXPECT_EQ(tree.get(15), 0);
+  EXPECT_EQ(tree.rangeGet(0, 100), 4 * 60 + 5 * 5);
+}
+
+TEST(PersistentDynamicSegmentTree, FuzzTestSnapshots) {
+  constexpr auto treeEnd = size_t{1000};
+  auto tree = PersistentSumTree(0, treeEnd, 0);
+  auto reference = SumSegTreeReference<size_t, int>(0, treeEnd, 0);
+
+  std::mt19937 generator(61);
+  auto snapshots = std::vector<PersistentSumTree::Snapshot>();
+  auto references = std::vector<SumSegTreeReference<size_t, int>>();
+
+  for (size_t i : iota(0, 300)) {
+    const auto [rngBegin, rngEnd] = GenerateIndRng(0, treeEnd)(generator);
+    const auto val = std::uniform_int_distribution(0, 1000)(generator);
+    if (std::bernoulli_distribution()(generator)) {
+      tree.set(rngBegin, rngEnd, val);
+      reference.set(rngBegin, rngEnd, val);
+    } else {
+      tree.update(rngBegin, rngEnd, val);
+      reference.update(rngBegin, rngEnd, std::plus<>(), val);
+    }
+    if (i % 30 == 0) {
+      snapshots.push_back(tree.snapshot());
+      references.push_back(reference);
+    }
+  }
+
+  for (size_t i : iota(size_t{0}, snapshots.size())) {
+    for (size_t j : iota(0, 50)) {
+      const auto [getBegin, getEnd] = GenerateIndRng(0, treeEnd)(generator);
+      if (getBegin < getEnd) {
+        EXPECT_EQ(snapshots[i].rangeGet(getBegin, getEnd),
+                  references[i].rangeGet(getBegin, getEnd));
+      }
+    }
+    for (size_t idx : iota(size_t{0}, treeEnd)) {
+      EXPECT_EQ(snapshots[i].get(idx), references[i].get(idx));
+    }
+  }
+}
+
+TEST(PersistentDynamicSegmentTree, NegateFuzzTest) {
+  constexpr auto treeEnd = size_t{1000};
+  auto tree = PersistentNegateTree(0, treeEnd, 42);
+  auto reference = SumSegTreeReference<size_t, int>(0, treeEnd, 42);
+  const auto initial = tree.snapshot();
+
+  std::mt19937 generator(62);
+
+  for (size_t i : iota(0, 300)) {
+    const auto [rngBegin, rngEnd] = GenerateIndRng(0, treeEnd)(generator);
+    if (std::bernoulli_distribution(0.2)(generator)) {
+      const auto val = std::uniform_int_distribution(0, 1000)(generator);
+      tree.set(rngBegin, rngEnd, val);
+      reference.set(rngBegin, rngEnd, val);
+    } else {
+      tree.update(rngBegin, rngEnd);
+      reference.update(rngBegin, rngEnd, std::negate<>());
+    }
+    const auto [getBegin, getEnd] = GenerateIndRng(0, treeEnd)(generator);
+    if (getBegin < getEnd) {
+      EXPECT_EQ(tree.rangeGet(getBegin, getEnd),
+                reference.rangeGet(getBegin, getEnd));
+    }
+  }
+
+  for (size_t idx : iota(size_t{0}, treeEnd)) {
+    EXPECT_EQ(tree.get(idx), reference.get(idx));
+  }
+  EXPECT_EQ(initial.rangeGet(0, treeEnd), 42 * 1000);
+}
+
+TEST(PersistentDynamicSegmentTree, CopyIsIndependent) {
+  auto tree = PersistentSumTree(0, 100, 1);
+  tree.set(10, 20, 2);
+
+  auto copy = tree;
+  copy.update(0, 100, 3);
+  tree.set(0, 15, 7);
+
+  EXPECT_EQ(tree.get(15), 2);
+  EXPECT_EQ(copy.get(15), 5);
+  EXPECT_EQ(copy.get(3), 4);
+  EXPECT_EQ(tree.rangeGet(0, 100), 7 * 15 + 2 * 5 + 80);
+  EXPECT_EQ(copy.rangeGet(0, 100), 410);
+}
+
+TEST(PersistentDynamicSegmentTree, OnlySharedPairsAreCopied) {
+  constexpr auto treeEnd = size_t{1 << 10};
+  const auto alloc = CountingAllocator<int>();
+  using Tree = dst::PersistentDynamicSegmentTree<
+      size_t, int, int, dst::comb::Sum<int>, SumInit, std::plus<int>, int,
+      CountingAllocator<int>>;
+  auto tree = Tree(0, treeEnd, 0, {}, {}, {}, alloc);
+  for (size_t i : iota(size_t{0}, treeEnd)) {
+    tree.set(i, i + 1, static_cast<int>(i));
+  }
+
+  // Nothing is shared, so pairs are changed in place.
+  auto calls = alloc.allocateCalls();
+  tree.update(3, 500, 1);
+  tree.set(100, 101, 5);
+  EXPECT_EQ(alloc.allocateCalls(), calls);
+
+  // Only pairs on the path of a write are copied.
+  const auto copy = tree;
+  EXPECT_EQ(alloc.allocateCalls(), calls);
+  tree.set(100, 101, 6);
+  EXPECT_EQ(alloc.allocateCalls(), calls + 10);
+
+  calls = alloc.allocateCalls();
+  tree.set(100, 101, 7);
+  EXPECT_EQ(alloc.allocateCalls(), calls);
+  EXPECT_EQ(copy.get(100), 5);
+}
+
+TEST(PersistentDynamicSegmentTree, SnapshotQueriedWhileWriting) {
+  constexpr auto treeEnd = size_t{1 << 12};
+  auto tree = PersistentSumTree(0, treeEnd, 1);
+  const auto snapshot = tree.snapshot();
+
+  auto reader = std::thread([&snapshot] {
+    for (size_t i : iota(0, 2000)) {
+      EXPECT_EQ(snapshot.rangeGet(i, treeEnd), static_cast<int>(treeEnd - i));
+    }
+  });
+  for (size_t i : iota(size_t{0}, size_t{2000})) {
+    tree.set(i, i + 7, 3);
+    tree.update(i / 2, i + 100, 1);
+  }
+  reader.join();
+}
+
+// NOLINTEND(cppcoreguidelines-*, cert-*, readability-magic-numbers,
+// cert-err58-cpp)
@@ -0,0 +1,178 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright Georgy Guminov 2023-2024.
+// Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt
+//  or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <dst/cache_upd.hpp>
+#include <dst/partial/dynamic_negate_segment_tree.hpp>
+#include <dst/partial/dynamic_simple_get_set_segment_tree.hpp>
+#include <dst/partial/dynamic_sum_segment_tree.hpp>
+#include <dst/serialization.hpp>
+#include <limits>
+#include <random>
+#include <ranges>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "tools/generate_index_range.hpp"
+
+using dst::DynamicSimpleGetSetSegmentTree;
+using dst::DynamicSumSegmentTree;
+using std::size_t;
+using std::views::iota;
+using GenerateIndRng = GenerateIndexRange<size_t>;
+
+template <>
+struct dst::Serializer<std::string> {
+  static void write(std::ostream& out, const std::string& value) {
+    Serializer<std::uint32_t>::write(out,
+                                     static_cast<std::uint32_t>(value.size()));
+    out.write(value.data(), static_cast<std::streamsize>(value.size()));
+  }
+
+  static std::string read(std::istream& in) {
+    auto ret = std::string(Serializer<std::uint32_t>::read(in), '\0');
+    in.read(ret.data(), static_cast<std::streamsize>(ret.size()));
+    return ret;
+  }
+};
+
+// NOLINTBEGIN(cppcoreguidelines-*, cert-*, readability-magic-numbers,
+// cert-err58-cpp)
+
+TEST(Serialization, FullKeyRangeTree) {
+  using Tree = DynamicSumSegmentTree<std::uint64_t, int>;
+  constexpr auto kMaxKey = std::numeric_limits<std::uint64_t>::max();
+  auto tree = Tree(dst::kFullKeyRange, 1);
+  tree.set(kMaxKey - 2, 0, 4);
+  tree.set(kMaxKey, 0, 9);
+
+  auto stream = std::stringstream();
+  tree.serialize(stream);
+  auto loaded = Tree::deserialize(stream);
+
+  EXPECT_EQ(loaded.get(kMaxKey), 9);
+  EXPECT_EQ(loaded.get(kMaxKey - 1), 4);
+  EXPECT_EQ(loaded.rangeGet(kMaxKey - 3, 0), 1 + 4 + 4 + 9);
+}
+
+TEST(Serialization, SumTreeWithPendingUpdates) {
+  constexpr auto treeEnd = size_t{1000};
+  using Tree = DynamicSumSegmentTree<
+      size_t, int, int, std::plus<int>, int, std::allocator<int>,
+      dst::RangeGetCacheWithUpdate<dst::cache_upd::AddToSum<int>>>;
+  auto tree = Tree(0, treeEnd, 0);
+
+  std::mt19937 generator(11);
+
+  for (size_t i : iota(0, 200)) {
+    const auto [rngBegin, rngEnd] = GenerateIndRng(0, treeEnd)(generator);
+    const auto val = std::uniform_int_distribution(0, 1000)(generator);
+    if (std::bernoulli_distribution()(generator)) {
+      tree.set(rngBegin, rngEnd, val);
+    } else {
+      tree.update(rngBegin, rngEnd, val);
+    }
+  }
+
+  auto stream = std::stringstream();
+  tree.serialize(stream);
+  auto loaded = Tree::deserialize(stream);
+
+  for (size_t idx : iota(size_t{0}, treeEnd)) {
+    EXPECT_EQ(loaded.get(idx), tree.get(idx));
+  }
+  EXPECT_EQ(loaded.rangeGet(0, treeEnd), tree.rangeGet(0, treeEnd));
+
+  // Delayed updates are restored, not applied.
+  loaded.update(10, 900, 5);
+  tree.update(10, 900, 5);
+  EXPECT_EQ(loaded.rangeGet(3, 997), tree.rangeGet(3, 997));
+}
+
+TEST(Serialization, NegateTree) {
+  constexpr auto treeEnd = size_t{1000};
+  using Tree = dst::DynamicNegateSegmentTree<size_t, int, int>;
+  auto tree = Tree(0, treeEnd, 7);
+
+  std::mt19937 generator(12);
+
+  for (size_t i : iota(0, 100)) {
+    const auto [rngBegin, rngEnd] = GenerateIndRng(0, treeEnd)(generator);
+    tree.update(rngBegin, rngEnd);
+  }
+
+  auto stream = std::stringstream();
+  tree.serialize(stream);
+  const auto loaded = Tree::deserialize(stream);
+
+  for (size_t idx : iota(size_t{0}, treeEnd)) {
+    EXPECT_EQ(loaded.get(idx), tree.get(idx));
+  }
+}
+
+TEST(Serialization, CustomValueSerializer) {
+  using Tree = DynamicSimpleGetSetSegmentTree<int, std::string>;
+  auto tree = Tree(-50, 50, "fill");
+  tree.set(-10, 3, "first");
+  tree.set(20, 21, "second");
+
+  auto stream = std::stringstream();
+  tree.serialize(stream);
+  const auto loaded = Tree::deserialize(stream);
+
+  for (int idx : iota(-50, 50)) {
+    EXPECT_EQ(loaded.get(idx), tree.get(idx));
+  }
+}
+
+TEST(Serialization, CorruptedStreamThrows) {
+  using Tree = DynamicSumSegmentTree<int, int>;
+  auto tree = Tree(0, 100, 1);
+  tree.set(3, 70, 2);
+
+  auto stream = std::stringstream();
+  tree.serialize(stream);
+  const auto data = stream.str();
+
+  auto truncated = std::stringstream(data.substr(0, data.size() - 3));
+  EXPECT_THROW(Tree::deserialize(truncated), std::runtime_error);
+
+  auto wrongMagic = std::stringstream("XYZW" + data.substr(4));
+  EXPECT_THROW(Tree::deserialize(wrongMagic), std::runtime_error);
+}
+
+TEST(Serialization, CorruptedNodesCountThrows) {
+  using Tree = DynamicSumSegmentTree<int, int>;
+  auto tree = Tree(0, 100, 1);
+  tree.set(3, 70, 2);
+
+  auto stream = std::stringstream();
+  tree.serialize(stream);
+  const auto data = stream.str();
+  // Magic and two keys precede nodes count.
+  constexpr auto kCountOffset = 4 + 2 * sizeof(int);
+
+  const auto withCount = [&](std::uint64_t count) {
+    auto corrupted = data;
+    for (size_t i : iota(size_t{0}, sizeof(count))) {
+      corrupted[kCountOffset + i] = static_cast<char>(count >> (8 * i));
+    }
+    return std::stringstream(corrupted);
+  };
+
+  auto huge = withCount(std::uint64_t{1} << 62);
+  EXPECT_THROW(Tree::deserialize(huge), std::runtime_error);
+  auto tooLarge = withCount(200);
+  EXPECT_THROW(Tree::deserialize(tooLarge), std::runtime_error);
+  auto zero = withCount(0);
+  EXPECT_THROW(Tree::deserialize(zero), std::runtime_error);
+}
+
+// NOLINTEND(cppcoreguidelines-*, cert-*, readability-magic-numbers,
+// cert-err58-cpp)
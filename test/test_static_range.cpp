@@ -0,0 +1,93 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright Georgy Guminov 2023-2024.
+// Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt
+//  or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <dst/comb.hpp>
+#include <dst/static_range_dynamic_segment_tree.hpp>
+#include <dst/upd.hpp>
+#include <functional>
+#include <random>
+#include <ranges>
+#include <stdexcept>
+
+#include "reference/sum_seg_tree_reference.hpp"
+#include "tools/generate_index_range.hpp"
+
+using std::size_t;
+using std::views::iota;
+using GenerateIndRng = GenerateIndexRange<size_t>;
+
+namespace {
+
+using SumInit = decltype([](int val, size_t begin, size_t end) {
+  return val * static_cast<int>(end - begin);
+});
+
+using StaticSumTree =
+    dst::StaticRangeDynamicSegmentTree<size_t, 0, 1024, int, int,
+                                       dst::comb::Sum<int>, SumInit,
+                                       std::plus<int>, int>;
+
+}  // namespace
+
+// NOLINTBEGIN(cppcoreguidelines-*, cert-*, readability-magic-numbers,
+// cert-err58-cpp)
+
+TEST(StaticRangeDynamicSegmentTree, SetAndGet) {
+  auto tree = dst::StaticRangeDynamicSegmentTree<int, -8, 8, int>(5);
+  tree.set(-3, 2, 8);
+
+  EXPECT_EQ(tree.get(-8), 5);
+  EXPECT_EQ(tree.get(-4), 5);
+  EXPECT_EQ(tree.get(-3), 8);
+  EXPECT_EQ(tree.get(1), 8);
+  EXPECT_EQ(tree.get(2), 5);
+  EXPECT_EQ(tree.get(7), 5);
+  EXPECT_THROW(tree.get(8), std::out_of_range);
+  EXPECT_THROW(tree.get(-9), std::out_of_range);
+}
+
+TEST(StaticRangeDynamicSegmentTree, NegateUpdates) {
+  auto tree =
+      dst::StaticRangeDynamicSegmentTree<unsigned, 16, 48, int, int,
+                                         dst::NoRangeGetOp, dst::NoRangeGetOp,
+                                         dst::upd::Negate<int>>(3);
+  tree.update(20, 40);
+  tree.update(30, 48);
+
+  EXPECT_EQ(tree.get(16), 3);
+  EXPECT_EQ(tree.get(25), -3);
+  EXPECT_EQ(tree.get(35), 3);
+  EXPECT_EQ(tree.get(45), -3);
+}
+
+TEST(StaticRangeDynamicSegmentTree, FuzzTestSetUpdateGet) {
+  auto tree = StaticSumTree(0);
+  auto reference = SumSegTreeReference<size_t, int>(0, 1024, 0);
+
+  std::mt19937 generator(23);
+
+  for (size_t i : iota(0, 200)) {
+    const auto [rngBegin, rngEnd] = GenerateIndRng(0, 1024)(generator);
+    const auto val = std::uniform_int_distribution(0, 100)(generator);
+    if (std::bernoulli_distribution()(generator)) {
+      tree.set(rngBegin, rngEnd, val);
+      reference.set(rngBegin, rngEnd, val);
+    } else {
+      tree.update(rngBegin, rngEnd, val);
+      reference.update(rngBegin, rngEnd, std::plus<>(), val);
+    }
+    for (size_t key : iota(size_t{0}, size_t{1024})) {
+      EXPECT_EQ(tree.get(key), reference.get(key));
+    }
+    EXPECT_EQ(tree.rangeGet(0, 1024), reference.rangeGet(0, 1024));
+  }
+}
+
+// NOLINTEND(cppcoreguidelines-*, cert-*, readability-magic-numbers,
+// cert-err58-cpp)
@@ -6,22 +6,58 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <dst/cache_upd.hpp>
+#include <dst/compose.hpp>
 #include <dst/partial/dynamic_sum_segment_tree.hpp>
+#include <iterator>
 #include <limits>
+#include <map>
+#include <optional>
 #include <random>
 #include <ranges>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 #include "reference/sum_seg_tree_reference.hpp"
+#include "tools/counting_allocator.hpp"
 #include "tools/generate_index_range.hpp"
 
 using dst::DynamicSumSegmentTree;
+using dst::NoUpdateOp;
 using std::int64_t;
 using std::size_t;
 using std::views::iota;
 using GenerateIndRng = GenerateIndexRange<size_t>;
 
+namespace {
+
+struct CountingSumInit {
+  size_t* calls;
+
+  int operator()(int val, size_t begin, size_t end) const {
+    ++*calls;
+    return val * static_cast<int>(end - begin);
+  }
+};
+
+struct CountingSum {
+  size_t* calls;
+
+  int operator()(int left, int right) const {
+    ++*calls;
+    return left + right;
+  }
+};
+
+}  // namespace
+
 // NOLINTBEGIN(cppcoreguidelines-*, cert-*, readability-magic-numbers,
 // cert-err58-cpp)
 
@@ -291,5 +327,849 @@ TEST(DynamicSumSegmentTree, IntRangeGivesInt64SumFuzzTest) {
   }
 }
 
+TEST(DynamicSumSegmentTree, CachedRangeGetPointSets) {
+  constexpr auto treeEnd = size_t{1000};
+  auto tree = DynamicSumSegmentTree<size_t, int, int, NoUpdateOp, void,
+                                    std::allocator<int>, dst::RangeGetCache>(
+      0, treeEnd, 0);
+  auto reference = SumSegTreeReference<size_t, int>(0, treeEnd, 0);
+
+  std::mt19937 generator(73);
+
+  for (size_t i : iota(0, 500)) {
+    const auto key = std::uniform_int_distribution<size_t>(0, 999)(generator);
+    const auto valToSet = std::uniform_int_distribution(0, 1000)(generator);
+    tree.set(key, key + 1, valToSet);
+    reference.set(key, key + 1, valToSet);
+    EXPECT_EQ(tree.rangeGet(0, treeEnd), reference.rangeGet(0, treeEnd));
+  }
+}
+
+TEST(DynamicSumSegmentTree, CachedRangeGetFuzzTestMixedSetUpdate) {
+  constexpr auto treeEnd = size_t{1000};
+  auto tree = DynamicSumSegmentTree<
+      size_t, int, int, std::plus<int>, int, std::allocator<int>,
+      dst::RangeGetCacheWithUpdate<dst::cache_upd::AddToSum<int>>>(0, treeEnd,
+                                                                    0);
+  auto reference = SumSegTreeReference<size_t, int>(0, treeEnd, 0);
+
+  std::mt19937 generator(54);
+
+  for (size_t i : iota(0, 300)) {
+    const auto [rngBegin, rngEnd] = GenerateIndRng(0, treeEnd)(generator);
+    const auto val = std::uniform_int_distribution(0, 1000)(generator);
+    if (std::bernoulli_distribution()(generator)) {
+      tree.set(rngBegin, rngEnd, val);
+      reference.set(rngBegin, rngEnd, val);
+    } else {
+      tree.update(rngBegin, rngEnd, val);
+      reference.update(rngBegin, rngEnd, std::plus<>(), val);
+    }
+    const auto [getBegin, getEnd] = GenerateIndRng(0, treeEnd)(generator);
+    if (getBegin < getEnd) {
+      EXPECT_EQ(tree.rangeGet(getBegin, getEnd),
+                reference.rangeGet(getBegin, getEnd));
+    }
+    EXPECT_EQ(tree.rangeGet(0, treeEnd), reference.rangeGet(0, treeEnd));
+  }
+}
+
+TEST(DynamicSumSegmentTree, CachedRangeGetUpdateCost) {
+  constexpr auto treeEnd = size_t{1} << 16;
+  auto initCalls = size_t{0};
+  auto tree = dst::DynamicSegmentTree<
+      size_t, int, int, dst::comb::Sum<int>, CountingSumInit, std::plus<int>,
+      int, std::allocator<int>,
+      dst::RangeGetCacheWithUpdate<dst::cache_upd::AddToSum<int>>>(
+      0, treeEnd, 0, {}, CountingSumInit{&initCalls});
+
+  for (size_t key = 0; key < treeEnd; key += 2) {
+    tree.set(key, key + 1, 1);
+  }
+
+  // Writes do not traverse subtrees, which got delayed updates.
+  initCalls = 0;
+  tree.update(100, 30000, 1);
+  EXPECT_LE(initCalls, 4 * 17);
+  initCalls = 0;
+  tree.update(0, treeEnd, 1);
+  EXPECT_LE(initCalls, 4 * 17);
+  initCalls = 0;
+  tree.set(50000, 50001, 3);
+  EXPECT_LE(initCalls, 4 * 17);
+
+  EXPECT_EQ(tree.rangeGet(0, treeEnd), int{treeEnd / 2 * 3} + 29900 + 1);
+  EXPECT_EQ(tree.rangeGet(100, 30000), 29900 / 2 * 3 + 29900);
+}
+
+TEST(DynamicSumSegmentTree, CachedRangeGetAfterUpdateCost) {
+  constexpr auto treeEnd = size_t{1} << 16;
+  auto combCalls = size_t{0};
+  auto initCalls = size_t{0};
+  auto tree = dst::DynamicSegmentTree<
+      size_t, int, int, CountingSum, CountingSumInit, std::plus<int>, int,
+      std::allocator<int>,
+      dst::RangeGetCacheWithUpdate<dst::cache_upd::AddToSum<int>>>(
+      0, treeEnd, 0, CountingSum{&combCalls}, CountingSumInit{&initCalls});
+
+  for (size_t key = 0; key < treeEnd; key += 2) {
+    tree.set(key, key + 1, 1);
+  }
+
+  // Cached result of a covered node is updated in place.
+  combCalls = 0;
+  initCalls = 0;
+  tree.update(0, treeEnd, 1);
+  EXPECT_EQ(combCalls, 0);
+  EXPECT_EQ(initCalls, 0);
+
+  // Covered subtrees below the delayed update are answered by their caches.
+  EXPECT_EQ(tree.rangeGet(1, treeEnd - 1), int{treeEnd / 2 * 3} - 3);
+  EXPECT_LE(combCalls, 2 * 17);
+  EXPECT_LE(initCalls, 2);
+
+  combCalls = 0;
+  initCalls = 0;
+  tree.update(1000, 40000, 2);
+  EXPECT_LE(combCalls, 2 * 17);
+  EXPECT_LE(initCalls, 4 * 17);
+
+  combCalls = 0;
+  initCalls = 0;
+  EXPECT_EQ(tree.rangeGet(0, treeEnd), int{treeEnd / 2 * 3} + 2 * 39000);
+  EXPECT_EQ(combCalls, 0);
+  EXPECT_EQ(tree.rangeGet(501, 50001),
+            49500 / 2 * 3 + 39000 * 2);
+  EXPECT_LE(combCalls, 2 * 17);
+  EXPECT_LE(initCalls, 2);
+}
+
+TEST(DynamicSumSegmentTree, ComposedUpdatesFuzzTest) {
+  constexpr auto treeEnd = size_t{1000};
+  auto tree = DynamicSumSegmentTree<size_t, int, int, std::plus<int>, int,
+                                    std::allocator<int>, dst::NoRangeGetCache,
+                                    dst::compose::Sum<int>>(0, treeEnd, 0);
+  auto reference = SumSegTreeReference<size_t, int>(0, treeEnd, 0);
+
+  std::mt19937 generator(37);
+
+  for (size_t i : iota(0, 300)) {
+    const auto [rngBegin, rngEnd] = GenerateIndRng(0, treeEnd)(generator);
+    const auto val = std::uniform_int_distribution(0, 1000)(generator);
+    if (std::bernoulli_distribution(0.2)(generator)) {
+      tree.set(rngBegin, rngEnd, val);
+      reference.set(rngBegin, rngEnd, val);
+    } else {
+      tree.update(rngBegin, rngEnd, val);
+      reference.update(rngBegin, rngEnd, std::plus<>(), val);
+    }
+    const auto [getBegin, getEnd] = GenerateIndRng(0, treeEnd)(generator);
+    if (getBegin < getEnd) {
+      EXPECT_EQ(tree.rangeGet(getBegin, getEnd),
+                reference.rangeGet(getBegin, getEnd));
+    }
+  }
+
+  for (size_t idx : iota(size_t{0}, treeEnd)) {
+    EXPECT_EQ(tree.get(idx), reference.get(idx));
+  }
+}
+
+TEST(DynamicSumSegmentTree, CoalescedPointSetsFreeNodes) {
+  constexpr auto treeEnd = size_t{1024};
+  const auto alloc = CountingAllocator<int>();
+  auto tree = DynamicSumSegmentTree<size_t, int, int, NoUpdateOp, void,
+                                    CountingAllocator<int>,
+                                    dst::NoRangeGetCache, dst::NoUpdateCompose,
+                                    dst::CoalesceEqualLeaves>(
+      0, treeEnd, 0, {}, {}, {}, alloc);
+
+  for (size_t i : iota(size_t{0}, treeEnd)) {
+    tree.set(i, i + 1, 7);
+  }
+
+  EXPECT_EQ(alloc.allocated(), 0);
+  EXPECT_EQ(tree.rangeGet(0, treeEnd), 7 * 1024);
+
+  tree.set(3, 500, 2);
+  tree.set(3, 500, 7);
+
+  EXPECT_EQ(alloc.allocated(), 0);
+}
+
+TEST(DynamicSumSegmentTree, CoalescedFuzzTestMixedSetUpdate) {
+  constexpr auto treeEnd = size_t{1000};
+  auto tree = DynamicSumSegmentTree<
+      size_t, int, int, std::plus<int>, int, std::allocator<int>,
+      dst::RangeGetCacheWithUpdate<dst::cache_upd::AddToSum<int>>,
+      dst::NoUpdateCompose,
+                                    dst::CoalesceEqualLeaves>(0, treeEnd, 0);
+  auto reference = SumSegTreeReference<size_t, int>(0, treeEnd, 0);
+
+  std::mt19937 generator(91);
+
+  for (size_t i : iota(0, 500)) {
+    const auto [rngBegin, rngEnd] = GenerateIndRng(0, treeEnd)(generator);
+    const auto val = std::uniform_int_distribution(0, 3)(generator);
+    if (std::bernoulli_distribution()(generator)) {
+      tree.set(rngBegin, rngEnd, val);
+      reference.set(rngBegin, rngEnd, val);
+    } else {
+      tree.update(rngBegin, rngEnd, val);
+      reference.update(rngBegin, rngEnd, std::plus<>(), val);
+    }
+    const auto [getBegin, getEnd] = GenerateIndRng(0, treeEnd)(generator);
+    if (getBegin < getEnd) {
+      EXPECT_EQ(tree.rangeGet(getBegin, getEnd),
+                reference.rangeGet(getBegin, getEnd));
+    }
+  }
+
+  for (size_t idx : iota(size_t{0}, treeEnd)) {
+    EXPECT_EQ(tree.get(idx), reference.get(idx));
+  }
+}
+
+TEST(DynamicSumSegmentTree, QueriesDoNotAllocate) {
+  constexpr auto treeEnd = size_t{1000};
+  const auto alloc = CountingAllocator<int>();
+  auto tree = DynamicSumSegmentTree<size_t, int, int, std::plus<int>, int,
+                                    CountingAllocator<int>>(
+      0, treeEnd, 1, {}, {}, {}, alloc);
+
+  tree.set(100, 200, 3);
+  tree.update(0, 500, 2);
+  const auto allocated = alloc.allocated();
+
+  EXPECT_EQ(tree.rangeGet(150, 151), 5);
+  EXPECT_EQ(tree.rangeGet(420, 700), 80 * 3 + 200);
+  EXPECT_EQ(tree.get(199), 5);
+  EXPECT_EQ(tree.get(600), 1);
+  EXPECT_EQ(alloc.allocated(), allocated);
+}
+
+TEST(DynamicSumSegmentTree, ConcurrentQueries) {
+  constexpr auto treeEnd = size_t{1000};
+  auto tree = DynamicSumSegmentTree<size_t, int, int, std::plus<int>, int>(
+      0, treeEnd, 0);
+  auto reference = SumSegTreeReference<size_t, int>(0, treeEnd, 0);
+
+  std::mt19937 generator(12);
+
+  for (size_t i : iota(0, 200)) {
+    const auto [rngBegin, rngEnd] = GenerateIndRng(0, treeEnd)(generator);
+    const auto val = std::uniform_int_distribution(0, 1000)(generator);
+    if (std::bernoulli_distribution(0.3)(generator)) {
+      tree.set(rngBegin, rngEnd, val);
+      reference.set(rngBegin, rngEnd, val);
+    } else {
+      tree.update(rngBegin, rngEnd, val);
+      reference.update(rngBegin, rngEnd, std::plus<>(), val);
+    }
+  }
+
+  const auto& constTree = tree;
+  auto mismatches = std::vector<size_t>(4, 0);
+  auto threads = std::vector<std::thread>();
+  for (size_t threadIdx : iota(size_t{0}, mismatches.size())) {
+    threads.emplace_back([&, threadIdx] {
+      std::mt19937 threadGenerator(threadIdx);
+      for (size_t i : iota(0, 2000)) {
+        const auto [getBegin, getEnd] =
+            GenerateIndRng(0, treeEnd)(threadGenerator);
+        if (getBegin < getEnd && constTree.rangeGet(getBegin, getEnd) !=
+                                     reference.rangeGet(getBegin, getEnd)) {
+          ++mismatches[threadIdx];
+        }
+        if (constTree.get(getBegin % treeEnd) !=
+            reference.get(getBegin % treeEnd)) {
+          ++mismatches[threadIdx];
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(mismatches, std::vector<size_t>(4, 0));
+}
+
+TEST(DynamicSumSegmentTree, SetBatchFuzzTest) {
+  constexpr auto treeEnd = size_t{1000};
+  auto tree = DynamicSumSegmentTree<size_t, int, int, std::plus<int>, int>(
+      0, treeEnd, 0);
+  auto reference = SumSegTreeReference<size_t, int>(0, treeEnd, 0);
+
+  std::mt19937 generator(44);
+
+  for (size_t i : iota(0, 30)) {
+    const auto [updBegin, updEnd] = GenerateIndRng(0, treeEnd)(generator);
+    tree.update(updBegin, updEnd, 3);
+    reference.update(updBegin, updEnd, std::plus<>(), 3);
+
+    auto batch = std::vector<std::tuple<size_t, size_t, int>>();
+    for (size_t j : iota(0, 40)) {
+      const auto [rngBegin, rngEnd] = GenerateIndRng(0, treeEnd)(generator);
+      const auto val = std::uniform_int_distribution(0, 1000)(generator);
+      batch.emplace_back(rngBegin, rngEnd, val);
+      reference.set(rngBegin, rngEnd, val);
+    }
+    tree.setBatch(batch);
+
+    EXPECT_EQ(tree.rangeGet(0, treeEnd), reference.rangeGet(0, treeEnd));
+  }
+
+  for (size_t idx : iota(size_t{0}, treeEnd)) {
+    EXPECT_EQ(tree.get(idx), reference.get(idx));
+  }
+}
+
+TEST(DynamicSumSegmentTree, SetBatchSortedPointsCached) {
+  constexpr auto treeEnd = size_t{1000};
+  auto tree = DynamicSumSegmentTree<size_t, int, int, NoUpdateOp, void,
+                                    std::allocator<int>, dst::RangeGetCache>(
+      0, treeEnd, 0);
+
+  auto batch = std::vector<std::tuple<size_t, size_t, int>>();
+  for (size_t idx : iota(size_t{0}, treeEnd)) {
+    batch.emplace_back(idx, idx + 1, static_cast<int>(idx % 10));
+  }
+  tree.setBatch(batch);
+
+  EXPECT_EQ(tree.rangeGet(0, treeEnd), 4500);
+  EXPECT_EQ(tree.rangeGet(5, 25), 90);
+  EXPECT_EQ(tree.get(997), 7);
+}
+
+TEST(DynamicSumSegmentTree, RangeGetBatchFuzzTest) {
+  constexpr auto treeEnd = size_t{1000};
+  auto tree = DynamicSumSegmentTree<
+      size_t, int, int, std::plus<int>, int, std::allocator<int>,
+      dst::RangeGetCacheWithUpdate<dst::cache_upd::AddToSum<int>>>(0, treeEnd,
+                                                                    0);
+  auto reference = SumSegTreeReference<size_t, int>(0, treeEnd, 0);
+
+  std::mt19937 generator(63);
+
+  for (size_t i : iota(0, 100)) {
+    const auto [rngBegin, rngEnd] = GenerateIndRng(0, treeEnd)(generator);
+    const auto val = std::uniform_int_distribution(0, 1000)(generator);
+    if (std::bernoulli_distribution()(generator)) {
+      tree.set(rngBegin, rngEnd, val);
+      reference.set(rngBegin, rngEnd, val);
+    } else {
+      tree.update(rngBegin, rngEnd, val);
+      reference.update(rngBegin, rngEnd, std::plus<>(), val);
+    }
+
+    auto ranges = std::vector<std::pair<size_t, size_t>>();
+    for (size_t j : iota(0, 20)) {
+      const auto [getBegin, getEnd] = GenerateIndRng(0, treeEnd)(generator);
+      ranges.emplace_back(getBegin, std::max(getEnd, getBegin + 1));
+    }
+    auto results = std::vector<int>(ranges.size());
+    tree.rangeGetBatch(ranges, results);
+
+    for (size_t j : iota(size_t{0}, ranges.size())) {
+      EXPECT_EQ(results[j],
+                reference.rangeGet(ranges[j].first, ranges[j].second));
+    }
+  }
+}
+
+TEST(DynamicSumSegmentTree, RangeGetBatchOutOfWorkingArea) {
+  auto tree = DynamicSumSegmentTree<int, int>(0, 16, 1);
+  tree.set(2, 5, 3);
+
+  const auto ranges = std::vector<std::pair<int, int>>{
+      {-2, 3}, {10, 40}, {-5, 30}, {4, 6}};
+  // Results are overwritten, not combined with previous values.
+  auto results = std::vector<int>(ranges.size(), 7);
+  tree.rangeGetBatch(ranges, results);
+  EXPECT_EQ(results, (std::vector<int>{5, 6, 22, 4}));
+
+  auto shortResults = std::vector<int>(ranges.size() - 1);
+  EXPECT_THROW(tree.rangeGetBatch(ranges, shortResults),
+               std::invalid_argument);
+}
+
+TEST(DynamicSumSegmentTree, GetManyFuzzTest) {
+  constexpr auto treeEnd = size_t{1000};
+  auto tree = DynamicSumSegmentTree<size_t, int, int, std::plus<int>, int>(
+      0, treeEnd, 0);
+  auto reference = SumSegTreeReference<size_t, int>(0, treeEnd, 0);
+
+  std::mt19937 generator(81);
+
+  for (size_t i : iota(0, 100)) {
+    const auto [rngBegin, rngEnd] = GenerateIndRng(0, treeEnd)(generator);
+    const auto val = std::uniform_int_distribution(0, 1000)(generator);
+    if (std::bernoulli_distribution()(generator)) {
+      tree.set(rngBegin, rngEnd, val);
+      reference.set(rngBegin, rngEnd, val);
+    } else {
+      tree.update(rngBegin, rngEnd, val);
+      reference.update(rngBegin, rngEnd, std::plus<>(), val);
+    }
+
+    const auto [keysBegin, keysEnd] = GenerateIndRng(0, treeEnd)(generator);
+    auto keys = std::vector<size_t>();
+    for (size_t key : iota(keysBegin, keysEnd)) {
+      keys.push_back(key);
+    }
+    // Unsorted keys are also allowed.
+    keys.push_back(std::uniform_int_distribution<size_t>(0, 999)(generator));
+    keys.push_back(0);
+
+    auto values = std::vector<int>();
+    tree.getMany(keys, std::back_inserter(values));
+
+    ASSERT_EQ(values.size(), keys.size());
+    for (size_t j : iota(size_t{0}, keys.size())) {
+      EXPECT_EQ(values[j], reference.get(keys[j]));
+    }
+  }
+}
+
+TEST(DynamicSumSegmentTree, GetManyOutOfRange) {
+  auto tree = DynamicSumSegmentTree<int, int>(0, 42, 54);
+  const auto keys = std::vector<int>{3, 42};
+  auto values = std::vector<int>(2);
+  EXPECT_THROW(tree.getMany(keys, values.begin()), std::out_of_range);
+}
+
+TEST(DynamicSumSegmentTree, LeavesFuzzTest) {
+  constexpr auto treeEnd = size_t{1000};
+  using Tree = DynamicSumSegmentTree<size_t, int, int, std::plus<int>, int>;
+  static_assert(std::forward_iterator<Tree::LeafIterator>);
+  auto tree = Tree(0, treeEnd, 0);
+  auto reference = SumSegTreeReference<size_t, int>(0, treeEnd, 0);
+
+  std::mt19937 generator(29);
+
+  for (size_t i : iota(0, 100)) {
+    const auto [rngBegin, rngEnd] = GenerateIndRng(0, treeEnd)(generator);
+    const auto val = std::uniform_int_distribution(0, 1000)(generator);
+    if (std::bernoulli_distribution()(generator)) {
+      tree.set(rngBegin, rngEnd, val);
+      reference.set(rngBegin, rngEnd, val);
+    } else {
+      tree.update(rngBegin, rngEnd, val);
+      reference.update(rngBegin, rngEnd, std::plus<>(), val);
+    }
+
+    auto prevEnd = size_t{0};
+    for (const auto& [segBegin, segEnd, value] : tree.leaves()) {
+      EXPECT_EQ(segBegin, prevEnd);
+      EXPECT_LT(segBegin, segEnd);
+      for (size_t key : iota(segBegin, segEnd)) {
+        EXPECT_EQ(value, reference.get(key));
+      }
+      prevEnd = segEnd;
+    }
+    EXPECT_EQ(prevEnd, treeEnd);
+  }
+}
+
+TEST(DynamicSumSegmentTree, LeavesOfWideTree) {
+  constexpr auto treeEnd = int64_t{1} << 40;
+  auto tree = DynamicSumSegmentTree<int64_t, int>(0, treeEnd, 1);
+  tree.set(5, int64_t{1} << 39, 2);
+
+  auto leavesCount = size_t{0};
+  auto sum = int64_t{0};
+  for (const auto& [segBegin, segEnd, value] : tree.leaves()) {
+    ++leavesCount;
+    sum += (segEnd - segBegin) * value;
+  }
+
+  EXPECT_LT(leavesCount, 100);
+  EXPECT_EQ(sum, treeEnd + (int64_t{1} << 39) - 5);
+}
+
+TEST(DynamicSumSegmentTree, LeavesOfEmptyWorkingArea) {
+  const auto empty = DynamicSumSegmentTree<int, int>(5, 5, 1);
+  const auto reversed = DynamicSumSegmentTree<int, int>(7, 3, 1);
+
+  EXPECT_TRUE(empty.leaves().empty());
+  EXPECT_TRUE(reversed.leaves().empty());
+}
+
+TEST(DynamicSumSegmentTree, ConstructFromRuns) {
+  constexpr auto treeEnd = size_t{1000};
+  auto reference = SumSegTreeReference<size_t, int>(0, treeEnd, -1);
+
+  std::mt19937 generator(8);
+
+  auto runs = std::vector<std::tuple<size_t, size_t, int>>();
+  for (size_t runBegin = 0; runBegin < treeEnd;) {
+    const auto length = std::uniform_int_distribution<size_t>(0, 40)(generator);
+    const auto runEnd = std::min(runBegin + length, treeEnd);
+    const auto val = std::uniform_int_distribution(0, 3)(generator);
+    // Some keys are left out of runs.
+    if (std::bernoulli_distribution(0.8)(generator)) {
+      runs.emplace_back(runBegin, runEnd, val);
+      reference.set(runBegin, runEnd, val);
+    }
+    runBegin = runEnd + std::uniform_int_distribution<size_t>(0, 3)(generator);
+  }
+
+  auto tree =
+      DynamicSumSegmentTree<size_t, int, int, NoUpdateOp, void,
+                            std::allocator<int>, dst::RangeGetCache,
+                            dst::NoUpdateCompose, dst::CoalesceEqualLeaves>(
+          0, treeEnd, runs, -1);
+
+  for (size_t idx : iota(size_t{0}, treeEnd)) {
+    EXPECT_EQ(tree.get(idx), reference.get(idx));
+  }
+  EXPECT_EQ(tree.rangeGet(0, treeEnd), reference.rangeGet(0, treeEnd));
+  EXPECT_EQ(tree.rangeGet(17, 503), reference.rangeGet(17, 503));
+}
+
+TEST(DynamicSumSegmentTree, ConstructFromLeaves) {
+  constexpr auto treeEnd = size_t{1000};
+  auto tree = DynamicSumSegmentTree<size_t, int, int, std::plus<int>, int>(
+      0, treeEnd, 0);
+
+  std::mt19937 generator(5);
+
+  for (size_t i : iota(0, 100)) {
+    const auto [rngBegin, rngEnd] = GenerateIndRng(0, treeEnd)(generator);
+    const auto val = std::uniform_int_distribution(0, 1000)(generator);
+    tree.set(rngBegin, rngEnd, val);
+    tree.update(rngEnd / 2, rngEnd, val);
+  }
+
+  auto runs = std::vector<std::tuple<size_t, size_t, int>>();
+  for (const auto& [segBegin, segEnd, value] : tree.leaves()) {
+    runs.emplace_back(segBegin, segEnd, value);
+  }
+  const auto rebuilt =
+      DynamicSumSegmentTree<size_t, int, int, std::plus<int>, int>(
+          0, treeEnd, runs);
+
+  for (size_t idx : iota(size_t{0}, treeEnd)) {
+    EXPECT_EQ(rebuilt.get(idx), tree.get(idx));
+  }
+}
+
+TEST(DynamicSumSegmentTree, FullKeyRangeSigned) {
+  using Limits = std::numeric_limits<int64_t>;
+  auto tree = DynamicSumSegmentTree<int64_t, int64_t, int64_t, std::plus<>,
+                                    int64_t>(dst::kFullKeyRange);
+
+  tree.set(Limits::min(), Limits::min() + 3, 5);
+  // A range ending with the minimal key includes the maximal one.
+  tree.set(Limits::max() - 2, Limits::min(), 7);
+  tree.set(-10, 10, 1);
+  tree.update(-1, 2, 3);
+  tree.update(Limits::max(), Limits::min(), 2);
+
+  EXPECT_EQ(tree.get(Limits::min()), 5);
+  EXPECT_EQ(tree.get(Limits::min() + 3), 0);
+  EXPECT_EQ(tree.get(Limits::max() - 1), 7);
+  EXPECT_EQ(tree.get(Limits::max()), 9);
+  EXPECT_EQ(tree.get(-1), 4);
+  EXPECT_EQ(tree.get(2), 1);
+  EXPECT_EQ(tree.rangeGet(Limits::min(), Limits::max()), 15 + 14 + 20 + 9);
+  EXPECT_EQ(tree.rangeGet(Limits::min(), Limits::min()),
+            15 + 14 + 20 + 9 + 9);
+  EXPECT_EQ(tree.rangeGet(Limits::max(), Limits::min()), 9);
+  EXPECT_EQ(tree.rangeGet(Limits::min() + 1, -5), 10 + 5);
+}
+
+TEST(DynamicSumSegmentTree, FullKeyRangeLastKey) {
+  using Limits = std::numeric_limits<uint64_t>;
+  using Tree =
+      DynamicSumSegmentTree<uint64_t, int, int, std::plus<>, int,
+                            std::allocator<int>,
+                            dst::RangeGetCacheWithUpdate<
+                                dst::cache_upd::AddToSum<int>>>;
+  auto tree = Tree(dst::kFullKeyRange, 0);
+
+  EXPECT_EQ(tree.exchange(Limits::max() - 1, 0, 3), 0);
+  EXPECT_EQ(tree.updateAndGet(Limits::max(), 0, 2), 5);
+  EXPECT_EQ(tree.updateAndGet(0, 2, 1), 2);
+  EXPECT_EQ(tree.get(Limits::max()), 5);
+  EXPECT_EQ(tree.get(Limits::max() - 1), 3);
+  EXPECT_EQ(tree.rangeArgMax(0, 0), std::pair(Limits::max(), 5));
+  EXPECT_EQ(tree.rangeArgMin(Limits::max() - 1, 0),
+            std::pair(Limits::max() - 1, 3));
+  EXPECT_EQ(tree.findFirst(Limits::max() - 1, 0,
+                           [](int sum) { return sum > 3; }),
+            Limits::max());
+  EXPECT_EQ(tree.findFirst(Limits::max() - 1, 0,
+                           [](int sum) { return sum > 8; }),
+            std::nullopt);
+  EXPECT_EQ(tree.findFirst(Limits::max(), 0, [](int sum) { return sum > 4; }),
+            Limits::max());
+
+  const auto batch = std::vector<std::tuple<uint64_t, uint64_t, int>>{
+      {Limits::max() - 1, 0, 6}, {Limits::max(), 0, 4}, {20, 30, 5}};
+  tree.setBatch(batch);
+  EXPECT_EQ(tree.get(Limits::max()), 4);
+  EXPECT_EQ(tree.get(Limits::max() - 1), 6);
+  EXPECT_EQ(tree.get(25), 5);
+
+  const auto ranges = std::vector<std::pair<uint64_t, uint64_t>>{
+      {Limits::max() - 1, 0},
+      {Limits::max(), 0},
+      {0, 12},
+      {Limits::max() - 3, 0}};
+  auto out = std::vector<int>(ranges.size());
+  tree.rangeGetBatch(ranges, out);
+  EXPECT_EQ(out[0], 6 + 4);
+  EXPECT_EQ(out[1], 4);
+  EXPECT_EQ(out[2], 2);
+  EXPECT_EQ(out[3], 6 + 4);
+
+  auto keys = std::vector<uint64_t>{3, Limits::max(), Limits::max() - 1};
+  auto values = std::vector<int>();
+  tree.getMany(std::span<const uint64_t>(keys), std::back_inserter(values));
+  EXPECT_EQ(values, (std::vector{0, 4, 6}));
+
+  // The maximal key is the last leaf run.
+  auto lastLeaf = std::optional<std::tuple<uint64_t, uint64_t, int>>();
+  for (const auto& [segBegin, segEnd, value] : tree.leaves()) {
+    lastLeaf.emplace(segBegin, segEnd, value);
+  }
+  EXPECT_EQ(lastLeaf, std::tuple(Limits::max(), uint64_t{0}, 4));
+
+  auto copy = tree;
+  copy.set(0, 0, 7);
+  EXPECT_EQ(copy.get(Limits::max()), 7);
+  EXPECT_EQ(tree.get(Limits::max()), 4);
+
+  // Ranges ending with zero are empty in a tree over a part of keys.
+  auto bounded = Tree(0, Limits::max(), 1);
+  bounded.set(Limits::max() - 1, 0, 3);
+  EXPECT_EQ(bounded.get(Limits::max() - 1), 1);
+  EXPECT_THROW(bounded.get(Limits::max()), std::out_of_range);
+}
+
+TEST(DynamicSumSegmentTree, FullKeyRangeUnsignedFuzzTest) {
+  auto tree = DynamicSumSegmentTree<uint64_t, int>(dst::kFullKeyRange);
+  auto reference = std::vector<std::pair<uint64_t, int>>();
+
+  std::mt19937_64 generator(11);
+
+  for (int i : iota(1, 200)) {
+    // The maximal key is drawn too, its range [max, 0) wraps.
+    const auto key = i % 50 == 0 ? std::numeric_limits<uint64_t>::max()
+                                 : generator();
+    tree.set(key, key + 1, i);
+    reference.emplace_back(key, i);
+  }
+
+  auto values = std::map<uint64_t, int>();
+  for (const auto& [key, value] : reference) {
+    values[key] = value;
+  }
+  auto sum = int64_t{0};
+  for (const auto& [key, value] : values) {
+    EXPECT_EQ(tree.get(key), value);
+    sum += value;
+  }
+  EXPECT_EQ(tree.rangeGet(0, 0), sum);
+  EXPECT_EQ(tree.rangeGet(0, std::numeric_limits<uint64_t>::max()),
+            sum - values[std::numeric_limits<uint64_t>::max()]);
+}
+
+TEST(DynamicSumSegmentTree, LowerBoundPrefix) {
+  auto tree = DynamicSumSegmentTree<int, int>(-10, 10, 0);
+  tree.set(-5, 0, 2);
+  tree.set(3, 7, 1);
+
+  EXPECT_EQ(tree.lowerBoundPrefix(0), -10);
+  EXPECT_EQ(tree.lowerBoundPrefix(1), -5);
+  EXPECT_EQ(tree.lowerBoundPrefix(2), -5);
+  EXPECT_EQ(tree.lowerBoundPrefix(7), -2);
+  EXPECT_EQ(tree.lowerBoundPrefix(10), -1);
+  EXPECT_EQ(tree.lowerBoundPrefix(11), 3);
+  EXPECT_EQ(tree.lowerBoundPrefix(14), 6);
+  EXPECT_EQ(tree.lowerBoundPrefix(15), std::nullopt);
+}
+
+TEST(DynamicSumSegmentTree, FindFirstFuzzTest) {
+  constexpr auto treeEnd = size_t{500};
+  auto tree = DynamicSumSegmentTree<
+      size_t, int, int, std::plus<int>, int, std::allocator<int>,
+      dst::RangeGetCacheWithUpdate<dst::cache_upd::AddToSum<int>>>(0, treeEnd,
+                                                                    0);
+  auto reference = SumSegTreeReference<size_t, int>(0, treeEnd, 0);
+
+  std::mt19937 generator(21);
+
+  for (size_t i : iota(0, 200)) {
+    const auto [rngBegin, rngEnd] = GenerateIndRng(0, treeEnd)(generator);
+    const auto val = std::uniform_int_distribution(0, 10)(generator);
+    if (std::bernoulli_distribution()(generator)) {
+      tree.set(rngBegin, rngEnd, val);
+      reference.set(rngBegin, rngEnd, val);
+    } else {
+      tree.update(rngBegin, rngEnd, val);
+      reference.update(rngBegin, rngEnd, std::plus<>(), val);
+    }
+    const auto [findBegin, findEnd] = GenerateIndRng(0, treeEnd)(generator);
+    const auto target = std::uniform_int_distribution(
+        0, reference.rangeGet(0, treeEnd) / 2 + 1)(generator);
+    const auto reaches = [target](int sum) { return sum >= target; };
+
+    auto expected = std::optional<size_t>();
+    for (size_t key = findBegin; key < findEnd; ++key) {
+      if (reaches(reference.rangeGet(findBegin, key + 1))) {
+        expected = key;
+        break;
+      }
+    }
+    EXPECT_EQ(tree.findFirst(findBegin, findEnd, reaches), expected);
+  }
+}
+
+TEST(DynamicSumSegmentTree, FindFirstCallCountBelowPendingUpdate) {
+  constexpr auto treeEnd = size_t{1} << 16;
+  auto combCalls = size_t{0};
+  auto initCalls = size_t{0};
+  auto tree = dst::DynamicSegmentTree<
+      size_t, int, int, CountingSum, CountingSumInit, std::plus<int>, int,
+      std::allocator<int>,
+      dst::RangeGetCacheWithUpdate<dst::cache_upd::AddToSum<int>>>(
+      0, treeEnd, 0, CountingSum{&combCalls}, CountingSumInit{&initCalls});
+
+  for (size_t key = 0; key < treeEnd; key += 2) {
+    tree.set(key, key + 1, 1);
+  }
+  tree.update(0, treeEnd, 1);
+
+  // Sum on [101, k + 1) is 3 * (k - 100) / 2 for even k.
+  combCalls = 0;
+  initCalls = 0;
+  EXPECT_EQ(
+      tree.findFirst(101, treeEnd - 101, [](int sum) { return sum >= 60000; }),
+      40100);
+  EXPECT_LE(combCalls + initCalls, 4 * 17);
+
+  combCalls = 0;
+  initCalls = 0;
+  EXPECT_EQ(tree.lowerBoundPrefix(90000), 59999);
+  EXPECT_LE(combCalls + initCalls, 2 * 17);
+}
+
+TEST(DynamicSumSegmentTree, KthFuzzTest) {
+  constexpr auto treeEnd = size_t{300};
+  auto tree = DynamicSumSegmentTree<
+      size_t, uint32_t, uint64_t, std::plus<uint32_t>, uint32_t,
+      std::allocator<uint32_t>,
+      dst::RangeGetCacheWithUpdate<dst::cache_upd::AddToSum<uint64_t>>>(
+      0, treeEnd, 0);
+  auto reference = SumSegTreeReference<size_t, uint32_t>(0, treeEnd, 0);
+
+  std::mt19937 generator(31);
+
+  for (size_t i : iota(0, 100)) {
+    const auto [rngBegin, rngEnd] = GenerateIndRng(0, treeEnd)(generator);
+    const auto val = std::uniform_int_distribution<uint32_t>(0, 5)(generator);
+    if (std::bernoulli_distribution()(generator)) {
+      tree.set(rngBegin, rngEnd, val);
+      reference.set(rngBegin, rngEnd, val);
+    } else {
+      tree.update(rngBegin, rngEnd, val);
+      reference.update(rngBegin, rngEnd, std::plus<>(), val);
+    }
+
+    // Keys of all units in order.
+    auto units = std::vector<size_t>();
+    for (size_t key : iota(size_t{0}, treeEnd)) {
+      units.insert(units.end(), reference.get(key), key);
+    }
+    for (size_t k = 0; k < units.size(); k += 7) {
+      EXPECT_EQ(tree.kth(k), units[k]);
+    }
+    EXPECT_EQ(tree.kth(units.size()), std::nullopt);
+  }
+}
+
+TEST(DynamicSumSegmentTree, KthCallCountWithUpdates) {
+  constexpr auto treeEnd = size_t{1} << 16;
+  auto combCalls = size_t{0};
+  auto initCalls = size_t{0};
+  auto tree = dst::DynamicSegmentTree<
+      size_t, int, int, CountingSum, CountingSumInit, std::plus<int>, int,
+      std::allocator<int>,
+      dst::RangeGetCacheWithUpdate<dst::cache_upd::AddToSum<int>>>(
+      0, treeEnd, 0, CountingSum{&combCalls}, CountingSumInit{&initCalls});
+
+  for (size_t key = 0; key < treeEnd; key += 2) {
+    tree.set(key, key + 1, 1);
+  }
+  // Each call is one descent, whatever updates are delayed on the way.
+  const auto expectKth = [&](int k, size_t expected) {
+    combCalls = 0;
+    initCalls = 0;
+    EXPECT_EQ(tree.kth(k), expected);
+    EXPECT_LE(combCalls + initCalls, 2 * 17);
+  };
+
+  expectKth(0, 0);
+  expectKth(12345, 24690);
+
+  tree.update(0, treeEnd, 1);
+  // Even keys hold 2 units, odd keys hold 1.
+  expectKth(0, 0);
+  expectKth(2, 1);
+  expectKth(12345, 8230);
+
+  tree.update(0, treeEnd / 2, 1);
+  // Even keys of the first half hold 3 units, odd keys hold 2.
+  expectKth(4, 1);
+  expectKth(12345, 4938);
+  expectKth(int{treeEnd / 4 * 5 + 2}, treeEnd / 2 + 1);
+}
+
+TEST(DynamicSumSegmentTree, Exchange) {
+  auto tree = DynamicSumSegmentTree<int, int>(0, 20, 1);
+  tree.set(5, 10, 3);
+
+  EXPECT_EQ(tree.exchange(3, 7, 2), 2 + 6);
+  EXPECT_EQ(tree.rangeGet(0, 20), 3 + 8 + 9 + 10);
+  EXPECT_EQ(tree.exchange(-5, 30, 0), 30);
+  EXPECT_EQ(tree.rangeGet(0, 20), 0);
+  EXPECT_THROW(tree.exchange(20, 30, 0), std::out_of_range);
+}
+
+TEST(DynamicSumSegmentTree, ExchangeUpdateAndGetFuzzTest) {
+  constexpr auto treeEnd = size_t{1000};
+  auto tree =
+      DynamicSumSegmentTree<size_t, int, int, std::plus<int>, int,
+                            std::allocator<int>,
+                            dst::RangeGetCacheWithUpdate<
+                                dst::cache_upd::AddToSum<int>>,
+                            dst::NoUpdateCompose, dst::CoalesceEqualLeaves>(
+          0, treeEnd, 0);
+  auto reference = SumSegTreeReference<size_t, int>(0, treeEnd, 0);
+
+  std::mt19937 generator(61);
+
+  for (size_t i : iota(0, 300)) {
+    const auto [rngBegin, rngEnd] = GenerateIndRng(0, treeEnd)(generator);
+    if (rngBegin == rngEnd) {
+      continue;
+    }
+    const auto val = std::uniform_int_distribution(0, 10)(generator);
+    if (std::bernoulli_distribution()(generator)) {
+      EXPECT_EQ(tree.exchange(rngBegin, rngEnd, val),
+                reference.rangeGet(rngBegin, rngEnd));
+      reference.set(rngBegin, rngEnd, val);
+    } else {
+      reference.update(rngBegin, rngEnd, std::plus<>(), val);
+      EXPECT_EQ(tree.updateAndGet(rngBegin, rngEnd, val),
+                reference.rangeGet(rngBegin, rngEnd));
+    }
+    EXPECT_EQ(tree.rangeGet(0, treeEnd), reference.rangeGet(0, treeEnd));
+  }
+}
+
 // NOLINTEND(cppcoreguidelines-*, cert-*, readability-magic-numbers,
 // cert-err58-cpp)
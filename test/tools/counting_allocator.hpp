@@ -0,0 +1,64 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright Georgy Guminov 2023-2024.
+// Distributed under the Boost Software License,
+// Version 1.0. (See accompanying file LICENSE_1_0.txt
+//  or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef COUNTING_ALLOCATOR_HPP
+#define COUNTING_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <memory>
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief The CountingAllocator<T> class. Counts currently allocated objects
+/// and allocate calls. Rebound copies share the counters.
+template <class T>
+class CountingAllocator {
+ public:
+  using value_type = T;
+
+ public:
+  CountingAllocator()
+      : counter_(std::make_shared<std::size_t>(0)),
+        calls_(std::make_shared<std::size_t>(0)) {
+  }
+  template <class U>
+  CountingAllocator(const CountingAllocator<U>& other)  // NOLINT
+      : counter_(other.counter_), calls_(other.calls_) {
+  }
+
+  T* allocate(std::size_t n) {
+    *counter_ += n;
+    ++*calls_;
+    return std::allocator<T>().allocate(n);
+  }
+
+  void deallocate(T* ptr, std::size_t n) {
+    *counter_ -= n;
+    std::allocator<T>().deallocate(ptr, n);
+  }
+
+  [[nodiscard]] std::size_t allocated() const {
+    return *counter_;
+  }
+
+  [[nodiscard]] std::size_t allocateCalls() const {
+    return *calls_;
+  }
+
+  template <class U>
+  bool operator==(const CountingAllocator<U>& other) const {
+    return counter_ == other.counter_;
+  }
+
+ private:
+  std::shared_ptr<std::size_t> counter_;
+  std::shared_ptr<std::size_t> calls_;
+
+ private:
+  template <class U>
+  friend class CountingAllocator;
+};
+
+#endif  // COUNTING_ALLOCATOR_HPP